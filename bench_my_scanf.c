@@ -0,0 +1,557 @@
+#define _GNU_SOURCE
+#include "my_scanf.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+    About the benchmark structure:
+
+    Each workload is a deterministic synthetic corpus with one record per
+    line (same seed, same bytes, every run) plus the format that reads one
+    record. The corpus is written to a file for the stream front ends and
+    kept in memory, one NUL-terminated line per record, for the string front
+    ends. Every implementation reads every record of the corpus and must
+    assign the expected number of fields each time, so a broken reader shows
+    up as an error instead of as a suspiciously fast number.
+
+    Implementations:
+    - scanf / my_scanf         : stdin redirected to the corpus file
+    - sscanf / my_sscanf       : one call per in-memory line
+    - my_fdscanf / my_mmscanf  : raw fd and memory-mapped file sources
+    - my_mmscanf_exec          : same, with the format compiled once
+    - my_scanner_uring         : io_uring scanner, reads kept in flight
+    - my_scanner_pipeline      : reader thread scanner, buffers queued ahead
+    Workloads that use custom specifiers (%b, %z, %q) have no glibc
+    baseline and only run the my_* implementations.
+
+    Usage: bench_my_scanf [--size MB] [--reps N] [--cpu N] [--only NAME]
+                          [--dir DIR] [--json FILE]
+*/
+
+// BENCHMARK CONFIGURATION
+typedef struct {
+    size_t size;          // corpus size in bytes (per workload)
+    int reps;             // timed repetitions, the best and median are reported
+    int cpu;              // CPU to pin to, -1 for no pinning
+    const char *only;     // run just this workload, NULL for all
+    const char *dir;      // where corpus files are written
+    const char *json;     // JSON report path, NULL for none
+} BenchConfig;
+
+// DETERMINISTIC GENERATORS
+// xorshift64*: tiny, fast and identical on every platform
+typedef struct { uint64_t state; } Rng;
+
+static uint64_t rng_next(Rng *rng) {
+    rng->state ^= rng->state >> 12;
+    rng->state ^= rng->state << 25;
+    rng->state ^= rng->state >> 27;
+    return rng->state * 0x2545F4914F6CDD1DULL;
+}
+
+static int rng_range(Rng *rng, int lo, int hi) {
+    return lo + (int)(rng_next(rng) % (uint64_t)(hi - lo + 1));
+}
+
+static int gen_word(Rng *rng, char *out, int min_len, int max_len) {
+    int len = rng_range(rng, min_len, max_len);
+    for (int i = 0; i < len; i++) {
+        out[i] = (char)('a' + rng_range(rng, 0, 25));
+    }
+    out[len] = '\0';
+    return len;
+}
+
+static int gen_sentence(Rng *rng, char *out, size_t size) {
+    int words = rng_range(rng, 2, 6);
+    int len = 0;
+    for (int w = 0; w < words && (size_t)len + 18 < size; w++) {
+        if (w > 0) {
+            out[len++] = (rng_range(rng, 0, 7) == 0) ? ',' : ' ';
+        }
+        len += gen_word(rng, out + len, 2, 9);
+        if (rng_range(rng, 0, 5) == 0) {
+            out[len++] = ' ';
+            out[len] = (char)('A' + rng_range(rng, 0, 25));
+            len++;
+            out[len] = '\0';
+        }
+    }
+    return len;
+}
+
+// Each generator writes one record (without the newline) and returns its length
+static int gen_int(Rng *rng, char *out, size_t size) {
+    return snprintf(out, size, "%d", (int)(uint32_t)rng_next(rng));
+}
+
+static int gen_long_long(Rng *rng, char *out, size_t size) {
+    return snprintf(out, size, "%lld", (long long)rng_next(rng));
+}
+
+static int gen_float(Rng *rng, char *out, size_t size) {
+    double v = (double)(rng_next(rng) % 10000000) / 1000.0;
+    return snprintf(out, size, "%.*f", rng_range(rng, 1, 3), (rng_next(rng) & 1) ? -v : v);
+}
+
+static int gen_double(Rng *rng, char *out, size_t size) {
+    double v = (double)(rng_next(rng) >> 11) * 0x1p-53 * 1e6;
+    switch (rng_range(rng, 0, 2)) {
+        case 0:  return snprintf(out, size, "%.17g", v);
+        case 1:  return snprintf(out, size, "%.6e", -v);
+        default: return snprintf(out, size, "%.9f", v);
+    }
+}
+
+static int gen_hex(Rng *rng, char *out, size_t size) {
+    unsigned v = (unsigned)(rng_next(rng) & 0x7FFFFFFF);
+    return snprintf(out, size, (v & 1) ? "0x%x" : "%X", v);
+}
+
+// 16-digit trace IDs, the shape %llx is there for
+static int gen_hex64(Rng *rng, char *out, size_t size) {
+    return snprintf(out, size, "%016llx", (unsigned long long)rng_next(rng));
+}
+
+static int gen_binary(Rng *rng, char *out, size_t size) {
+    int bits = rng_range(rng, 1, 31);
+    uint64_t v = rng_next(rng);
+    int len = (rng_range(rng, 0, 3) == 0) ? snprintf(out, size, "0b") : 0;
+    for (int i = bits - 1; i >= 0 && (size_t)len + 1 < size; i--) {
+        out[len++] = (char)('0' + ((v >> i) & 1));
+    }
+    out[len] = '\0';
+    return len;
+}
+
+// 32-64 character bitmap columns, for %llb
+static int gen_bitmap(Rng *rng, char *out, size_t size) {
+    int bits = rng_range(rng, 32, 64);
+    uint64_t v = rng_next(rng);
+    int len = 0;
+    for (int i = bits - 1; i >= 0 && (size_t)len + 1 < size; i--) {
+        out[len++] = (char)('0' + ((v >> i) & 1));
+    }
+    out[len] = '\0';
+    return len;
+}
+
+static int gen_string(Rng *rng, char *out, size_t size) {
+    (void)size;
+    return gen_word(rng, out, 3, 16);
+}
+
+static int gen_combo(Rng *rng, char *out, size_t size) {
+    char word[32];
+    gen_word(rng, word, 3, 12);
+    double v = (double)(rng_next(rng) % 100000000) / 100.0;
+    return snprintf(out, size, "%d,%.2f %s", rng_range(rng, 0, 1000000), v, word);
+}
+
+static int gen_int_string_int(Rng *rng, char *out, size_t size) {
+    char word[32];
+    gen_word(rng, word, 3, 12);
+    return snprintf(out, size, "%d %s %d", (int)(uint32_t)rng_next(rng), word,
+                    rng_range(rng, -100000, 100000));
+}
+
+static int gen_text(Rng *rng, char *out, size_t size) {
+    return gen_sentence(rng, out, size);
+}
+
+// WORKLOADS
+// Formats read exactly one record. %f, %z and %q stop in front of a newline
+// instead of skipping it, so their formats carry a whitespace directive that
+// moves on to the next line.
+typedef struct {
+    const char *name;
+    const char *format;
+    int fields;           // assignments expected per record
+    int custom;           // uses my_scanf-only specifiers, no glibc baseline
+    int (*gen)(Rng *rng, char *out, size_t size);
+} Workload;
+
+static const Workload workloads[] = {
+    { "int",        "%d",          1, 0, gen_int },
+    { "long_long",  "%lld",        1, 0, gen_long_long },
+    { "float",      " %f",         1, 0, gen_float },
+    { "double",     " %lf",        1, 0, gen_double },
+    { "hex",        "%x",          1, 0, gen_hex },
+    { "hex64",      "%llx",        1, 0, gen_hex64 },
+    { "string",     "%s",          1, 0, gen_string },
+    { "combo",      "%d,%lf %s",   3, 0, gen_combo },
+    { "int_str_int","%d %31s %d",  3, 0, gen_int_string_int },
+    { "binary",     "%b",          1, 1, gen_binary },
+    { "bitmap64",   "%llb",        1, 1, gen_bitmap },
+    { "genz",       "%z ",         1, 1, gen_text },
+    { "cipher",     "%3q ",        1, 1, gen_text },
+};
+#define NUM_WORKLOADS ((int)(sizeof(workloads) / sizeof(workloads[0])))
+
+// CORPUS
+typedef struct {
+    char path[4096];      // file holding the corpus
+    char *lines;          // same bytes with every '\n' replaced by '\0'
+    size_t *offsets;      // start of each line in lines
+    size_t bytes;
+    size_t records;
+} Corpus;
+
+static int corpus_build(Corpus *corpus, const Workload *w, size_t size, const char *dir, int index) {
+    memset(corpus, 0, sizeof(*corpus));
+    Rng rng = { 0x9E3779B97F4A7C15ULL ^ (uint64_t)(index + 1) * 0xD1B54A32D192ED03ULL };
+
+    size_t cap = size + 512, max_records = size / 2 + 1;
+    corpus->lines = malloc(cap);
+    corpus->offsets = malloc(max_records * sizeof(size_t));
+    if (corpus->lines == NULL || corpus->offsets == NULL) {
+        return -1;
+    }
+    while (corpus->bytes < size && corpus->records < max_records) {
+        int len = w->gen(&rng, corpus->lines + corpus->bytes, 256);
+        corpus->offsets[corpus->records++] = corpus->bytes;
+        corpus->bytes += (size_t)len;
+        corpus->lines[corpus->bytes++] = '\n';
+    }
+
+    snprintf(corpus->path, sizeof(corpus->path), "%s/my_scanf_bench_%s.txt", dir, w->name);
+    FILE *fp = fopen(corpus->path, "w");
+    if (fp == NULL || fwrite(corpus->lines, 1, corpus->bytes, fp) != corpus->bytes) {
+        if (fp) fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    for (size_t i = 0; i < corpus->bytes; i++) {
+        if (corpus->lines[i] == '\n') {
+            corpus->lines[i] = '\0';
+        }
+    }
+    return 0;
+}
+
+static void corpus_free(Corpus *corpus) {
+    unlink(corpus->path);
+    free(corpus->lines);
+    free(corpus->offsets);
+}
+
+// IMPLEMENTATIONS
+// Each runner reads every record once and returns how many records it got
+// with all fields assigned (anything short of corpus->records is an error).
+// Destinations are big enough and aligned enough for any conversion.
+typedef union {
+    long double ld;
+    long long ll;
+    double d;
+    char s[512];
+} Slot;
+
+static Slot slots[3];
+
+static size_t run_scanf(const Corpus *corpus, const Workload *w) {
+    if (freopen(corpus->path, "r", stdin) == NULL) {
+        return 0;
+    }
+    size_t ok = 0;
+    for (size_t i = 0; i < corpus->records; i++) {
+        ok += (scanf(w->format, slots[0].s, slots[1].s, slots[2].s) == w->fields);
+    }
+    return ok;
+}
+
+static size_t run_my_scanf(const Corpus *corpus, const Workload *w) {
+    if (freopen(corpus->path, "r", stdin) == NULL) {
+        return 0;
+    }
+    size_t ok = 0;
+    for (size_t i = 0; i < corpus->records; i++) {
+        ok += (my_scanf(w->format, slots[0].s, slots[1].s, slots[2].s) == w->fields);
+    }
+    return ok;
+}
+
+static size_t run_sscanf(const Corpus *corpus, const Workload *w) {
+    size_t ok = 0;
+    for (size_t i = 0; i < corpus->records; i++) {
+        const char *line = corpus->lines + corpus->offsets[i];
+        ok += (sscanf(line, w->format, slots[0].s, slots[1].s, slots[2].s) == w->fields);
+    }
+    return ok;
+}
+
+static size_t run_my_sscanf(const Corpus *corpus, const Workload *w) {
+    size_t ok = 0;
+    for (size_t i = 0; i < corpus->records; i++) {
+        const char *line = corpus->lines + corpus->offsets[i];
+        ok += (my_sscanf(line, w->format, slots[0].s, slots[1].s, slots[2].s) == w->fields);
+    }
+    return ok;
+}
+
+static size_t run_my_fdscanf(const Corpus *corpus, const Workload *w) {
+    int fd = open(corpus->path, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    size_t ok = 0;
+    for (size_t i = 0; i < corpus->records; i++) {
+        ok += (my_fdscanf(fd, w->format, slots[0].s, slots[1].s, slots[2].s) == w->fields);
+    }
+    my_fdscanf_release(fd);
+    close(fd);
+    return ok;
+}
+
+static size_t run_my_mmscanf(const Corpus *corpus, const Workload *w) {
+    my_scanf_mmap *m = my_mmap_open(corpus->path, 0);
+    if (m == NULL) {
+        return 0;
+    }
+    size_t ok = 0;
+    for (size_t i = 0; i < corpus->records; i++) {
+        ok += (my_mmscanf(m, w->format, slots[0].s, slots[1].s, slots[2].s) == w->fields);
+    }
+    my_mmap_close(m);
+    return ok;
+}
+
+static size_t run_my_mmscanf_exec(const Corpus *corpus, const Workload *w) {
+    my_scanf_mmap *m = my_mmap_open(corpus->path, 0);
+    my_scanf_program *prog = my_scanf_compile(w->format);
+    size_t ok = 0;
+    for (size_t i = 0; m != NULL && prog != NULL && i < corpus->records; i++) {
+        ok += (my_mmscanf_exec(m, prog, slots[0].s, slots[1].s, slots[2].s) == w->fields);
+    }
+    my_scanf_free(prog);
+    my_mmap_close(m);
+    return ok;
+}
+
+static size_t run_read_ahead(const Corpus *corpus, const Workload *w, int pipeline) {
+    int fd = open(corpus->path, O_RDONLY);
+    my_scanner_t *sc = NULL;
+    if (fd >= 0) {
+        sc = pipeline ? my_scanner_open_pipeline(fd, 0, 0) : my_scanner_open_uring(fd, 0, 0);
+    }
+    size_t ok = 0;
+    for (size_t i = 0; sc != NULL && i < corpus->records; i++) {
+        ok += (my_scanner_scanf(sc, w->format, slots[0].s, slots[1].s, slots[2].s) == w->fields);
+    }
+    my_scanner_close(sc);
+    if (fd >= 0) {
+        close(fd);
+    }
+    return ok;
+}
+
+static size_t run_my_scanner_uring(const Corpus *corpus, const Workload *w) {
+    return run_read_ahead(corpus, w, 0);
+}
+
+static size_t run_my_scanner_pipeline(const Corpus *corpus, const Workload *w) {
+    return run_read_ahead(corpus, w, 1);
+}
+
+// Speedups are relative to the first implementation that ran in the same
+// group: scanf for the file readers and sscanf for the string readers (or
+// my_scanf / my_sscanf when the workload has no glibc baseline).
+typedef enum { GROUP_FILE, GROUP_STRING, NUM_GROUPS } ImplGroup;
+
+typedef struct {
+    const char *name;
+    int glibc;            // only understands standard specifiers
+    ImplGroup group;
+    size_t (*run)(const Corpus *corpus, const Workload *w);
+} Impl;
+
+static const Impl impls[] = {
+    { "scanf",           1, GROUP_FILE,   run_scanf },
+    { "my_scanf",        0, GROUP_FILE,   run_my_scanf },
+    { "sscanf",          1, GROUP_STRING, run_sscanf },
+    { "my_sscanf",       0, GROUP_STRING, run_my_sscanf },
+    { "my_fdscanf",      0, GROUP_FILE,   run_my_fdscanf },
+    { "my_mmscanf",      0, GROUP_FILE,   run_my_mmscanf },
+    { "my_mmscanf_exec", 0, GROUP_FILE,   run_my_mmscanf_exec },
+    { "my_scanner_uring", 0, GROUP_FILE,  run_my_scanner_uring },
+    { "my_scanner_pipeline", 0, GROUP_FILE, run_my_scanner_pipeline },
+};
+#define NUM_IMPLS ((int)(sizeof(impls) / sizeof(impls[0])))
+
+// TIMING AND REPORTING
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+typedef struct {
+    double best;          // seconds
+    double median;
+    int errors;           // repetitions that did not read every record
+} Timing;
+
+static Timing time_impl(const Impl *impl, const Corpus *corpus, const Workload *w, int reps) {
+    double *times = malloc((size_t)reps * sizeof(double));
+    Timing t = { 0.0, 0.0, 0 };
+    for (int r = 0; r < reps; r++) {
+        double start = now_seconds();
+        size_t ok = impl->run(corpus, w);
+        times[r] = now_seconds() - start;
+        if (ok != corpus->records) {
+            t.errors++;
+        }
+    }
+    qsort(times, (size_t)reps, sizeof(double), compare_doubles);
+    t.best = times[0];
+    t.median = times[reps / 2];
+    free(times);
+    return t;
+}
+
+static int pin_to_cpu(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [--size MB] [--reps N] [--cpu N|-1] [--only WORKLOAD]\n"
+            "          [--dir DIR] [--json FILE]\n"
+            "  --size  corpus size per workload in MB (default 16)\n"
+            "  --reps  timed repetitions per implementation (default 5)\n"
+            "  --cpu   pin to this CPU (default: the CPU we start on, -1 = no pinning)\n"
+            "  --only  run a single workload\n"
+            "  --dir   directory for corpus files (default /tmp)\n"
+            "  --json  also write the results as JSON\n", prog);
+}
+
+// MAIN BENCHMARK
+int main(int argc, char **argv) {
+    BenchConfig cfg = { 16u << 20, 5, sched_getcpu(), NULL, "/tmp", NULL };
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (val == NULL) {
+            usage(argv[0]);
+            return 2;
+        }
+        if (strcmp(arg, "--size") == 0) {
+            cfg.size = (size_t)(strtod(val, NULL) * (1 << 20));
+        } else if (strcmp(arg, "--reps") == 0) {
+            cfg.reps = atoi(val);
+        } else if (strcmp(arg, "--cpu") == 0) {
+            cfg.cpu = atoi(val);
+        } else if (strcmp(arg, "--only") == 0) {
+            cfg.only = val;
+        } else if (strcmp(arg, "--dir") == 0) {
+            cfg.dir = val;
+        } else if (strcmp(arg, "--json") == 0) {
+            cfg.json = val;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+        i++;
+    }
+    if (cfg.reps < 1 || cfg.size == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (cfg.cpu >= 0 && pin_to_cpu(cfg.cpu) != 0) {
+        fprintf(stderr, "warning: cannot pin to CPU %d: %s\n", cfg.cpu, strerror(errno));
+        cfg.cpu = -1;
+    }
+
+    FILE *json = NULL;
+    if (cfg.json != NULL) {
+        json = fopen(cfg.json, "w");
+        if (json == NULL) {
+            fprintf(stderr, "cannot write %s: %s\n", cfg.json, strerror(errno));
+            return 1;
+        }
+        fprintf(json, "{\n  \"size_bytes\": %zu,\n  \"reps\": %d,\n  \"cpu\": %d,\n  \"results\": [",
+                cfg.size, cfg.reps, cfg.cpu);
+    }
+
+    printf("\n=== MY_SCANF BENCHMARK ===\n");
+    printf("corpus %.1f MB per workload, best of %d reps, cpu %d\n\n",
+           (double)cfg.size / (1 << 20), cfg.reps, cfg.cpu);
+    printf("%-12s %-20s %10s %10s %10s %10s %8s\n",
+           "workload", "impl", "MB/s", "Mrec/s", "ns/call", "median ns", "vs base");
+
+    int failures = 0, first_result = 1;
+    for (int wi = 0; wi < NUM_WORKLOADS; wi++) {
+        const Workload *w = &workloads[wi];
+        if (cfg.only != NULL && strcmp(cfg.only, w->name) != 0) {
+            continue;
+        }
+
+        Corpus corpus;
+        if (corpus_build(&corpus, w, cfg.size, cfg.dir, wi) != 0) {
+            fprintf(stderr, "cannot build corpus for %s in %s\n", w->name, cfg.dir);
+            corpus_free(&corpus);
+            failures++;
+            continue;
+        }
+
+        double baseline[NUM_GROUPS] = { 0.0, 0.0 };
+        for (int ii = 0; ii < NUM_IMPLS; ii++) {
+            const Impl *impl = &impls[ii];
+            if (impl->glibc && w->custom) {
+                continue;
+            }
+            Timing t = time_impl(impl, &corpus, w, cfg.reps);
+            double records = (double)corpus.records;
+            double mb_s = (double)corpus.bytes / t.best / 1e6;
+            double rec_s = records / t.best;
+            double ns_call = t.best * 1e9 / records;
+            double ns_median = t.median * 1e9 / records;
+            if (baseline[impl->group] == 0.0) {
+                baseline[impl->group] = t.best;
+            }
+            double speedup = baseline[impl->group] / t.best;
+
+            printf("%-12s %-20s %10.1f %10.2f %10.1f %10.1f %7.2fx%s\n",
+                   w->name, impl->name, mb_s, rec_s / 1e6, ns_call, ns_median, speedup,
+                   t.errors ? "  ERROR: records not matched" : "");
+            failures += (t.errors > 0);
+
+            if (json != NULL) {
+                fprintf(json,
+                        "%s\n    { \"workload\": \"%s\", \"format\": \"%s\", \"impl\": \"%s\", "
+                        "\"bytes\": %zu, \"records\": %zu, \"best_s\": %.6f, \"median_s\": %.6f, "
+                        "\"mb_per_s\": %.2f, \"records_per_s\": %.0f, \"ns_per_call\": %.2f, "
+                        "\"errors\": %d }",
+                        first_result ? "" : ",", w->name, w->format, impl->name,
+                        corpus.bytes, corpus.records, t.best, t.median,
+                        mb_s, rec_s, ns_call, t.errors);
+                first_result = 0;
+            }
+        }
+        printf("\n");
+        corpus_free(&corpus);
+    }
+
+    if (json != NULL) {
+        fprintf(json, "\n  ]\n}\n");
+        fclose(json);
+    }
+    return (failures == 0) ? 0 : 1;
+}
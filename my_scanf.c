@@ -1,29 +1,54 @@
+#include "my_scanf.h"
+#include "my_scanf_internal.h"
 #include <stdio.h>
 #include <stdarg.h>
 #include <ctype.h>
 #include <string.h>
 #include <limits.h>
 #include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <float.h>
+
+#ifdef MY_SCANF_STATS
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+#endif
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 
 // FORMAT SPECIFIER STRUCTURE
 // Represents a parsed format specifier like "%*5ld" or "%!3q"
-// Components are parsed in order: %[*][!][width][length]specifier
+// Components are parsed in order: %[*][!][width][m][length]specifier
 typedef struct {
-    char specifier;      // 'd', 's', 'c', 'f', 'x', 'z', 'q', 'b'
+    char specifier;      // 'd', 's', 'c', 'f', 'x', 'z', 'q', 'b', 'v'
     int field_width;     // if app. for %31s, this is 31; 0 means no limit
     char length_mod[3];  // "ll", "l", "h", or ""
     int suppress;        // 1 if '*' is present, 0 otherwise
     int exclaim;         // 1 if '!' is present, 0 otherwise for %z and %q
+    int alloc;           // 1 if 'm' is present: %mq / %mz store a malloc'd char *
 } FormatSpecifier;
 
 // FORMAT SPECIFIER PARSER
 // Parses a format specifier starting immediately after '%'
-// Format: %[*][!][width][length]specifier
+// Format: %[*][!][width][m][length]specifier
 // Examples:
 //   "%5d"   → width=5, specifier='d'
 //   "%*ld"  → suppress=1, length_mod="l", specifier='d'
 //   "%!3q"  → exclaim=1, width=3, specifier='q'
+//   "%!mhz" → exclaim=1, alloc=1, length_mod="h", specifier='z'
 // Returns: Number of characters consumed from the format string
 static int parse_format_specifier(const char *format, FormatSpecifier *spec) {
     int pos = 0;
@@ -34,6 +59,7 @@ static int parse_format_specifier(const char *format, FormatSpecifier *spec) {
     spec->specifier = '\0';
     spec->suppress = 0;
     spec->exclaim = 0;  // Renamed from invert_case
+    spec->alloc = 0;
 
     // Check for assignment suppression '*' first
     if (format[pos] == '*') {
@@ -53,6 +79,12 @@ static int parse_format_specifier(const char *format, FormatSpecifier *spec) {
         pos++;
     }
 
+    // Check for the allocation flag 'm' (after the width, as in POSIX %ms)
+    if (format[pos] == 'm') {
+        spec->alloc = 1;
+        pos++;
+    }
+
     // Parse length modifier (h, l, ll, L)
     if (format[pos] == 'h') {
         spec->length_mod[0] = 'h';
@@ -81,181 +113,892 @@ static int parse_format_specifier(const char *format, FormatSpecifier *spec) {
     return pos;
 }
 
-// HELPER FUNCTIONS to my_scanf()
-// Whitespace Handling
-static void skip_whitespace() {
-    int c;
-    while ((c = getchar()) != EOF && isspace(c)) {
-        // Keep reading until non-whitespace
+// INSTRUMENTATION
+// With MY_SCANF_STATS defined the hot paths bump counters through the STAT_*
+// macros below; without it every STAT_* expands to nothing, so a normal build
+// carries no trace of them. Each source charges the counters of the scanner
+// it belongs to, or the calling thread's counters if it has none.
+#ifdef MY_SCANF_STATS
+static _Thread_local my_scanf_stats thread_stats;
+
+static inline uint64_t stats_clock(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+#define STAT_ADD(src, field, n) (source_stats(src)->field += (unsigned long long)(n))
+#define STAT_INC(src, field)    (source_stats(src)->field++)
+#else
+#define STAT_ADD(src, field, n) ((void)0)
+#define STAT_INC(src, field)    ((void)0)
+#endif
+
+
+// INPUT SOURCES
+// The readers never touch stdin directly; they pull characters out of an
+// InputSource. Every source exposes the same window [cur, end) of buffered
+// bytes, so the hot loops are plain pointer walks: src_getc() is a compare
+// and an increment, and pushing a byte back is just cur--. Only when the
+// window runs dry do we make one indirect call to the source's refill().
+//
+//   memory sources  - the window is the caller's string itself, no copying
+//   fd sources      - a private, cache-line aligned buffer filled by read(2)
+//   FILE* sources   - with glibc, stdio's own read buffer is the window;
+//                     elsewhere bytes come from getc_unlocked() one refill at
+//                     a time. Either way we never take more from the stream
+//                     than scanf would
+//
+// my_scanf, my_fscanf, my_sscanf and my_fdscanf share one engine
+// (my_vscanf_source) regardless of where the bytes come from.
+#define SOURCE_BUFFER_SIZE  (64 * 1024)
+#define SOURCE_BUFFER_ALIGN 64
+
+typedef struct InputSource InputSource;
+
+struct InputSource {
+    const char *cur;     // next unread byte
+    const char *end;     // one past the last buffered byte
+    // Appends more bytes after end while keeping [cur, end) buffered.
+    // Returns the number of bytes added; 0 means EOF (or a read error).
+    size_t (*refill)(InputSource *src);
+    char *buf;           // private buffer backing the window (fd/FILE sources)
+    size_t cap;
+    int owns_buf;        // buf is heap memory this source must free
+    const char *mark;    // scanner checkpoint: bytes from here on are kept
+    FILE *file;          // FILE* sources
+    int borrowed;        // FILE* sources: [cur, end) is stdio's buffer, not buf
+    int fd;              // raw fd sources
+#ifdef MY_SCANF_STATS
+    size_t shifted;      // bytes dropped from the front by src_compact
+    my_scanf_stats *stats;  // owning scanner's counters, NULL for the thread's
+#endif
+};
+
+#ifdef MY_SCANF_STATS
+static inline my_scanf_stats *source_stats(const InputSource *src) {
+    return (src->stats != NULL) ? src->stats : &thread_stats;
+}
+#endif
+
+static inline int src_getc(InputSource *src) {
+    if (src->cur == src->end && src->refill(src) == 0) {
+        return EOF;
     }
+    return (unsigned char)*src->cur++;
+}
+
+// Only ever used for the byte src_getc() just returned, which is still in the
+// window (refill keeps everything from cur onwards), so this cannot underflow.
+static inline void src_ungetc(InputSource *src, int c) {
     if (c != EOF) {
-        ungetc(c, stdin);  // Put back the non-whitespace char
+        src->cur--;
+        STAT_INC(src, pushbacks);
     }
 }
 
-// STANDARD TYPE READERS
-// Each read_* function:
-//   1. Skips leading whitespace
-//   2. Checks for optional sign (+/-)
-//   3. Reads digits/characters up to field_width limit
-//   4. Puts back the first non-matching character with ungetc()
-//   5. Returns: 1 (success), 0 (no valid input), -1 (EOF before any input)
+// A checkpoint pins every byte from the mark onwards, so when those fill the
+// buffer it has to grow instead. Returns the number of free bytes (0 if
+// memory runs out).
+static size_t src_grow(InputSource *src) {
+    size_t keep = (size_t)(src->end - src->buf);
+    size_t cap = (src->cap * 2 > 256) ? src->cap * 2 : 256;
+    cap = (cap + SOURCE_BUFFER_ALIGN - 1) & ~(size_t)(SOURCE_BUFFER_ALIGN - 1);
+    char *buf = aligned_alloc(SOURCE_BUFFER_ALIGN, cap);
+    if (buf == NULL) {
+        return 0;
+    }
+    memcpy(buf, src->buf, keep);
+    src->cur = buf + (src->cur - src->buf);
+    src->mark = buf + (src->mark - src->buf);
+    src->end = buf + keep;
+    if (src->owns_buf) {
+        free(src->buf);
+    }
+    src->buf = buf;
+    src->cap = cap;
+    src->owns_buf = 1;
+    return cap - keep;
+}
 
-// Read signed integer with optional field width limit
-int read_integer(int* d, int field_width) {
-    // Skip leading whitespace
-    int c = getchar();
-    while (c != EOF && isspace(c)) {
-        c = getchar();
+// Slides the bytes still needed (unread, or pinned by a checkpoint) to the
+// front of the buffer so the free space after them is as large as possible.
+// Returns the number of free bytes.
+static size_t src_compact(InputSource *src) {
+    const char *from = (src->mark != NULL) ? src->mark : src->cur;
+    size_t keep = (size_t)(src->end - from);
+    if (from != src->buf) {
+#ifdef MY_SCANF_STATS
+        src->shifted += (size_t)(from - src->buf);
+#endif
+        memmove(src->buf, from, keep);
+        src->cur = src->buf + (src->cur - from);
+        src->end = src->buf + keep;
+        if (src->mark != NULL) {
+            src->mark = src->buf;
+        }
     }
+    if (keep == src->cap && src->mark != NULL) {
+        return src_grow(src);
+    }
+    return src->cap - keep;
+}
 
-    // Now c is either a non-whitespace char or EOF
+// Memory source: the whole input is already in the window
+static size_t mem_refill(InputSource *src) {
+    (void)src;
+    return 0;
+}
+
+// FILE* source. The caller holds the stream lock for the whole my_fscanf
+// call, and whatever is left unread is handed back before the lock is
+// dropped.
+//
+// With glibc the window is borrowed straight from stdio: [cur, end) is the
+// stream's [_IO_read_ptr, _IO_read_end), and stdio's read pointer is only
+// moved up to cur when the window is given back, so the stream loses exactly
+// the bytes that were parsed. A checkpoint (or a reader asking to keep bytes
+// across a refill) pins bytes that stdio's next underflow would overwrite, so
+// those are copied into buf and, until the window drains, the source falls
+// back to appending one getc_unlocked() byte per refill. That fallback is all
+// other C libraries get.
+#if defined(__GLIBC__) && !defined(__UCLIBC__)
+#define FILE_BORROWS_STDIO_BUFFER 1
+#endif
+
+#ifdef FILE_BORROWS_STDIO_BUFFER
+// Points the window at stdio's buffered bytes, underflowing once if there
+// are none. Only called with nothing in the window left to keep (a mark, if
+// any, sits at end).
+static size_t file_borrow(InputSource *src) {
+    FILE *stream = src->file;
+    // Until the borrow succeeds the window is an empty buf, so a failed
+    // underflow leaves no stale pointer into stdio behind
+    src->cur = src->end = src->buf;
+    if (src->mark != NULL) {
+        src->mark = src->buf;
+    }
+    src->borrowed = 0;
+    if (stream->_IO_read_ptr >= stream->_IO_read_end) {
+        int c = getc_unlocked(stream);
+        if (c == EOF) {
+            return 0;
+        }
+        ungetc(c, stream);  // just steps _IO_read_ptr back over c
+    }
+    src->cur = stream->_IO_read_ptr;
+    src->end = stream->_IO_read_end;
+    if (src->mark != NULL) {
+        src->mark = src->cur;  // nothing was pinned yet, so it starts here
+    }
+    src->borrowed = 1;
+    return (size_t)(src->end - src->cur);
+}
+
+// Ends a borrow: stdio is told everything before upto is consumed, and the
+// bytes from the mark (or cur) up to upto move into buf. Returns 0 if buf
+// cannot grow to hold them, with nothing changed.
+static int file_unborrow(InputSource *src, const char *upto) {
+    const char *from = (src->mark != NULL) ? src->mark : src->cur;
+    size_t keep = (upto > from) ? (size_t)(upto - from) : 0;
+    if (keep > src->cap) {
+        size_t cap = (keep + SOURCE_BUFFER_ALIGN - 1) & ~(size_t)(SOURCE_BUFFER_ALIGN - 1);
+        char *buf = aligned_alloc(SOURCE_BUFFER_ALIGN, cap);
+        if (buf == NULL) {
+            return 0;
+        }
+        if (src->owns_buf) {
+            free(src->buf);
+        }
+        src->buf = buf;
+        src->cap = cap;
+        src->owns_buf = 1;
+    }
+    memcpy(src->buf, from, keep);
+    src->file->_IO_read_ptr = (char *)upto;
+    src->cur = src->buf + (src->cur - from);
+    if (src->mark != NULL) {
+        src->mark = src->buf;
+    }
+    src->end = src->buf + keep;
+    src->borrowed = 0;
+    return 1;
+}
+#endif
+
+static size_t file_refill(InputSource *src) {
+    STAT_INC(src, refills);
+#ifdef FILE_BORROWS_STDIO_BUFFER
+    const char *from = (src->mark != NULL) ? src->mark : src->cur;
+    if (from == src->end) {
+        if (src->borrowed) {
+            src->file->_IO_read_ptr = (char *)src->end;
+        }
+        return file_borrow(src);
+    }
+    if (src->borrowed && !file_unborrow(src, src->end)) {
+        return 0;
+    }
+#endif
+    if (src_compact(src) == 0) {
+        return 0;
+    }
+    int c = getc_unlocked(src->file);
     if (c == EOF) {
-        return -1;
+        return 0;
     }
+    *(char *)src->end = (char)c;
+    src->end++;
+    return 1;
+}
 
-    int chars_read = 0;
-    int max_chars = (field_width > 0) ? field_width : INT_MAX;
+static void file_source_init(InputSource *src, FILE *stream, char *window, size_t size) {
+    memset(src, 0, sizeof(*src));
+    src->cur = src->end = src->buf = window;
+    src->cap = size;
+    src->refill = file_refill;
+    src->file = stream;
+}
 
-    // Check for sign
-    int sign = 1;
-    if ((c == '-' || c == '+') && chars_read < max_chars) {
-        if (c == '-') {
-            sign = -1;
+// Unread lookahead goes back to the stream. A borrowed window just moves
+// stdio's read pointer back to cur. Otherwise ungetc() only promises one
+// byte, so anything more (left by a rollback) or bytes pinned by a
+// checkpoint stay in the window for the scanner's next call instead.
+static void file_source_finish(InputSource *src) {
+#ifdef FILE_BORROWS_STDIO_BUFFER
+    if (src->borrowed) {
+        if (!file_unborrow(src, src->cur)) {
+            // No memory to keep the checkpoint's bytes: leave them in stdio
+            // and drop the checkpoint instead
+            src->file->_IO_read_ptr = (char *)src->mark;
+            src->mark = NULL;
+            src->cur = src->end = src->buf;
+            src->borrowed = 0;
         }
-        chars_read++;
-        c = getchar();
+        return;
+    }
+#endif
+    if (src->mark != NULL || src->end - src->cur > 1) {
+        return;
     }
+    while (src->end > src->cur) {
+        src->end--;
+        ungetc((unsigned char)*src->end, src->file);
+    }
+}
 
-    int value = 0;
-    int read_any_digits = 0;
+// Raw fd source: large reads into the private buffer. Buffered bytes have to
+// outlive the call (the next my_fdscanf on the same fd must see them), so each
+// fd gets its own InputSource in a lazily grown table, much like stdio keeps
+// one buffer per FILE. The table is shared by every thread, so growing it,
+// adding to it and releasing from it happen under fd_sources_lock. The
+// sources themselves never move, so a call keeps using its source after the
+// lock is dropped; like read(2) on one descriptor, scanning the same fd from
+// two threads at once is up to the caller to serialize.
+static size_t fd_refill(InputSource *src) {
+    STAT_INC(src, refills);
+    size_t room = src_compact(src);
+    if (room == 0) {
+        return 0;
+    }
 
-    while (c != EOF && isdigit(c) && chars_read < max_chars) {
-        int digit = c - '0';
-        value = value * 10 + digit;
-        read_any_digits = 1;
-        chars_read++;
-        c = getchar();
+    ssize_t n;
+    do {
+        n = read(src->fd, (char *)src->end, room);
+    } while (n < 0 && errno == EINTR);
+
+    if (n <= 0) {
+        return 0;
     }
+    src->end += n;
+    return (size_t)n;
+}
 
-    // Put back the last character (it wasn't a digit)
-    if (c != EOF) {
-        ungetc(c, stdin);
+static InputSource **fd_sources = NULL;  // fd_sources[fd], NULL until first use
+static int fd_sources_size = 0;
+static pthread_mutex_t fd_sources_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static InputSource *fd_source_new(int fd) {
+    InputSource *src = calloc(1, sizeof(*src));
+    char *buf = aligned_alloc(SOURCE_BUFFER_ALIGN, SOURCE_BUFFER_SIZE);
+    if (src == NULL || buf == NULL) {
+        free(src);
+        free(buf);
+        return NULL;
+    }
+    src->buf = buf;
+    src->cap = SOURCE_BUFFER_SIZE;
+    src->owns_buf = 1;
+    src->cur = src->end = buf;
+    src->refill = fd_refill;
+    src->fd = fd;
+    return src;
+}
+
+// Call with fd_sources_lock held
+static InputSource *fd_source_lookup(int fd) {
+    if (fd >= fd_sources_size) {
+        int new_size = (fd_sources_size > 0) ? fd_sources_size : 16;
+        while (new_size <= fd) {
+            new_size *= 2;
+        }
+        InputSource **grown = realloc(fd_sources, (size_t)new_size * sizeof(*grown));
+        if (grown == NULL) {
+            return NULL;
+        }
+        for (int i = fd_sources_size; i < new_size; i++) {
+            grown[i] = NULL;
+        }
+        fd_sources = grown;
+        fd_sources_size = new_size;
     }
 
-    if (read_any_digits) {
-        *d = value * sign;
-        return 1;
+    if (fd_sources[fd] == NULL) {
+        fd_sources[fd] = fd_source_new(fd);
     }
+    return fd_sources[fd];
+}
 
-    return 0;
+static InputSource *fd_source_get(int fd) {
+    if (fd < 0) {
+        return NULL;
+    }
+    pthread_mutex_lock(&fd_sources_lock);
+    InputSource *src = fd_source_lookup(fd);
+    pthread_mutex_unlock(&fd_sources_lock);
+    return src;
 }
 
-// Variations of the read_integer function for different sizes of integers
-int read_long(long* d, int field_width) {
-    // Skip leading whitespace
-    int c = getchar();
-    while (c != EOF && isspace(c)) {
-        c = getchar();
+// Drops whatever my_fdscanf is holding for fd, the way fclose() drops a
+// FILE's buffer. Must be called before the descriptor is closed or reused.
+void my_fdscanf_release(int fd) {
+    InputSource *src = NULL;
+    pthread_mutex_lock(&fd_sources_lock);
+    if (fd >= 0 && fd < fd_sources_size) {
+        src = fd_sources[fd];
+        fd_sources[fd] = NULL;
     }
+    pthread_mutex_unlock(&fd_sources_lock);
+    if (src != NULL) {
+        free(src->buf);
+        free(src);
+    }
+}
 
-    // Now c is either a non-whitespace char or EOF
-    if (c == EOF) {
-        return -1;
+// Memory-mapped file source: the whole file is one window, served straight
+// from the page cache with no read(2) copies and no refills. The kernel is
+// told we walk it front to back so it reads ahead aggressively and drops
+// pages behind us. Files that cannot be mapped (pipes, /proc, ...) are read
+// into a heap buffer instead, so callers never need a second code path.
+struct my_scanf_mmap {
+    InputSource src;     // window over the whole file, cur = scan position
+    char *data;
+    size_t len;
+    int mapped;          // 1 if data came from mmap(), 0 if from malloc()
+};
+
+static char *read_whole_fd(int fd, size_t *len) {
+    size_t cap = SOURCE_BUFFER_SIZE, used = 0;
+    char *data = malloc(cap);
+    while (data != NULL) {
+        if (used == cap) {
+            char *grown = realloc(data, cap * 2);
+            if (grown == NULL) {
+                break;
+            }
+            data = grown;
+            cap *= 2;
+        }
+        ssize_t n = read(fd, data + used, cap - used);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            break;
+        }
+        if (n == 0) {
+            *len = used;
+            return data;
+        }
+        used += (size_t)n;
     }
+    free(data);
+    return NULL;
+}
 
-    int chars_read = 0;
-    int max_chars = (field_width > 0) ? field_width : INT_MAX;
+my_scanf_mmap *my_mmap_open(const char *path, int flags) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    my_scanf_mmap *m = calloc(1, sizeof(*m));
+    struct stat st;
+    if (m == NULL || fstat(fd, &st) != 0) {
+        free(m);
+        close(fd);
+        return NULL;
+    }
 
-    // Check for sign
-    int sign = 1;
-    if ((c == '-' || c == '+') && chars_read < max_chars) {
-        if (c == '-') {
-            sign = -1;
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+        int map_flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+        if (flags & MY_MMAP_POPULATE) {
+            map_flags |= MAP_POPULATE;
+        }
+#endif
+        void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, map_flags, fd, 0);
+        if (data != MAP_FAILED) {
+            m->data = data;
+            m->len = (size_t)st.st_size;
+            m->mapped = 1;
+            madvise(data, m->len, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+            if (flags & MY_MMAP_HUGEPAGE) {
+                madvise(data, m->len, MADV_HUGEPAGE);  // only a hint, may be refused
+            }
+#endif
+        }
+    }
+    if (!m->mapped) {
+        m->data = read_whole_fd(fd, &m->len);
+        if (m->data == NULL) {
+            free(m);
+            close(fd);
+            return NULL;
         }
-        chars_read++;
-        c = getchar();
     }
+    close(fd);
 
-    long value = 0;
-    int read_any_digits = 0;
+    m->src.cur = m->data;
+    m->src.end = m->data + m->len;
+    m->src.refill = mem_refill;
+    return m;
+}
 
-    while (c != EOF && isdigit(c) && chars_read < max_chars) {
-        int digit = c - '0';
-        value = value * 10 + digit;
-        read_any_digits = 1;
-        chars_read++;
-        c = getchar();
+void my_mmap_close(my_scanf_mmap *m) {
+    if (m == NULL) {
+        return;
     }
-
-    // Put back the last character (it wasn't a digit)
-    if (c != EOF) {
-        ungetc(c, stdin);
+    if (m->mapped) {
+        munmap(m->data, m->len);
+    } else {
+        free(m->data);
     }
+    free(m);
+}
 
-    if (read_any_digits) {
-        *d = value * sign;
-        return 1;
+// SCANNER CONTEXTS
+// A my_scanner_t bundles one input source with everything a scan needs
+// between calls: its lookahead buffer, its counters and the resources it
+// owns. Scanners share nothing with each other, so every thread can drive
+// its own without locks (FILE* scanners still take that stream's lock).
+// my_scanf is a thin wrapper over the calling thread's default scanner,
+// which reads whatever stdin currently is.
+typedef enum {
+    SCANNER_MEMORY,      // string or buffer, the caller keeps it alive
+    SCANNER_MMAP,        // file mapped by my_scanner_open_path
+    SCANNER_FD,          // private read(2) buffer
+    SCANNER_FILE,        // FILE*, one byte of lookahead handed back after each call
+    SCANNER_READER,      // whole buffers from a my_buffer_reader (io_uring, reader thread)
+    SCANNER_STDIN        // the per-thread default, follows the current stdin
+} ScannerKind;
+
+struct my_scanner {
+    InputSource src;
+    ScannerKind kind;
+    my_scanf_mmap *map;  // SCANNER_MMAP
+    my_buffer_reader *reader;  // SCANNER_READER
+    char *spill;         // SCANNER_READER: holds the window while a checkpoint pins it
+    size_t spill_cap;
+    char window[1];      // SCANNER_FILE / SCANNER_STDIN, when stdio's buffer can't be borrowed
+    my_scanf_stats stats;
+};
+
+static _Thread_local my_scanner_t default_scanner;
+static _Thread_local int default_scanner_ready;
+
+static my_scanner_t *scanner_new(ScannerKind kind) {
+    my_scanner_t *sc = calloc(1, sizeof(*sc));
+    if (sc != NULL) {
+        sc->kind = kind;
+#ifdef MY_SCANF_STATS
+        sc->src.stats = &sc->stats;
+#endif
+    }
+    return sc;
+}
+
+my_scanner_t *my_scanner_default(void) {
+    if (!default_scanner_ready) {
+        default_scanner.kind = SCANNER_STDIN;
+        file_source_init(&default_scanner.src, stdin, default_scanner.window,
+                         sizeof(default_scanner.window));
+#ifdef MY_SCANF_STATS
+        default_scanner.src.stats = &thread_stats;  // my_scanf_stats_get() sees these
+#endif
+        default_scanner_ready = 1;
+    }
+    return &default_scanner;
+}
+
+my_scanner_t *my_scanner_open_memory(const char *buf, size_t len) {
+    my_scanner_t *sc = scanner_new(SCANNER_MEMORY);
+    if (sc != NULL) {
+        sc->src.cur = buf;
+        sc->src.end = buf + len;
+        sc->src.refill = mem_refill;
     }
+    return sc;
+}
+
+my_scanner_t *my_scanner_open_string(const char *str) {
+    return my_scanner_open_memory(str, strlen(str));
+}
+
+my_scanner_t *my_scanner_open_fd(int fd, size_t buffer_size) {
+    if (fd < 0) {
+        return NULL;
+    }
+    if (buffer_size == 0) {
+        buffer_size = SOURCE_BUFFER_SIZE;
+    }
+    // aligned_alloc wants a multiple of the alignment
+    buffer_size = (buffer_size + SOURCE_BUFFER_ALIGN - 1) & ~(size_t)(SOURCE_BUFFER_ALIGN - 1);
+
+    my_scanner_t *sc = scanner_new(SCANNER_FD);
+    char *buf = aligned_alloc(SOURCE_BUFFER_ALIGN, buffer_size);
+    if (sc == NULL || buf == NULL) {
+        free(sc);
+        free(buf);
+        return NULL;
+    }
+    sc->src.buf = buf;
+    sc->src.cap = buffer_size;
+    sc->src.owns_buf = 1;
+    sc->src.cur = sc->src.end = buf;
+    sc->src.refill = fd_refill;
+    sc->src.fd = fd;
+    return sc;
+}
+
+my_scanner_t *my_scanner_open_file(FILE *stream) {
+    if (stream == NULL) {
+        return NULL;
+    }
+    my_scanner_t *sc = scanner_new(SCANNER_FILE);
+    if (sc != NULL) {
+#ifdef MY_SCANF_STATS
+        my_scanf_stats *stats = sc->src.stats;
+#endif
+        file_source_init(&sc->src, stream, sc->window, sizeof(sc->window));
+#ifdef MY_SCANF_STATS
+        sc->src.stats = stats;
+#endif
+    }
+    return sc;
+}
+
+my_scanner_t *my_scanner_open_path(const char *path, int mmap_flags) {
+    my_scanf_mmap *map = my_mmap_open(path, mmap_flags);
+    my_scanner_t *sc = (map != NULL) ? scanner_new(SCANNER_MMAP) : NULL;
+    if (sc == NULL) {
+        my_mmap_close(map);
+        return NULL;
+    }
+    sc->map = map;
+    sc->src.cur = map->data;
+    sc->src.end = map->data + map->len;
+    sc->src.refill = mem_refill;
+    return sc;
+}
 
+// Buffer reader source (io_uring, reader thread): the window is whichever
+// buffer the reader handed over last, parsed where the bytes were read to.
+// The engine only refills an empty window, so normally nothing has to be
+// carried over; a short unread tail would go into the headroom in front of
+// the new buffer. A checkpoint can pin more than that, and the reader
+// recycles its buffer on the next call, so then the pinned bytes move to the
+// scanner's spill buffer and the new data is appended behind them.
+static int spill_reserve(my_scanner_t *sc, size_t size) {
+    if (size <= sc->spill_cap) {
+        return 0;
+    }
+    size_t cap = (size > 2 * sc->spill_cap) ? size : 2 * sc->spill_cap;
+    char *spill = malloc(cap);
+    if (spill == NULL) {
+        return -1;
+    }
+    free(sc->spill);
+    sc->spill = spill;
+    sc->spill_cap = cap;
     return 0;
 }
 
-int read_long_long(long long* d, int field_width) {
-    // Skip leading whitespace
-    int c = getchar();
-    while (c != EOF && isspace(c)) {
-        c = getchar();
+static size_t reader_refill(InputSource *src) {
+    STAT_INC(src, refills);
+    my_scanner_t *sc = (my_scanner_t *)src;
+    const char *from = (src->mark != NULL) ? src->mark : src->cur;
+    size_t keep = (size_t)(src->end - from);
+    size_t cur_off = (size_t)(src->cur - from);
+#ifdef MY_SCANF_STATS
+    uintptr_t old_cur = (uintptr_t)src->cur;
+#endif
+
+    // Save the kept bytes before the reader can reuse their buffer
+    char tail[MY_READER_HEADROOM];
+    int spilled = (keep > sizeof(tail));
+    if (spilled) {
+        if (src->buf != sc->spill && spill_reserve(sc, keep) != 0) {
+            return 0;
+        }
+        memmove(sc->spill, from, keep);
+    } else if (keep > 0) {
+        memcpy(tail, from, keep);
+    }
+
+    char *data;
+    size_t n = sc->reader->next(sc->reader, &data);
+    char *base;
+    if (n > 0 && !spilled) {
+        base = data - keep;
+        memcpy(base, tail, keep);
+    } else if (keep > 0) {
+        // Spilled, or EOF with bytes that must stay readable
+        if (!spilled && spill_reserve(sc, MY_READER_HEADROOM) != 0) {
+            return 0;
+        }
+        if (!spilled) {
+            memcpy(sc->spill, tail, keep);
+        }
+        if (n > 0 && sc->spill_cap < keep + n) {
+            char *grown = realloc(sc->spill, keep + n);
+            if (grown == NULL) {
+                n = 0;
+            } else {
+                sc->spill = grown;
+                sc->spill_cap = keep + n;
+            }
+        }
+        if (n > 0) {
+            memcpy(sc->spill + keep, data, n);
+        }
+        base = sc->spill;
+    } else {
+        return 0;
     }
 
-    // Now c is either a non-whitespace char or EOF
-    if (c == EOF) {
-        return -1;
+#ifdef MY_SCANF_STATS
+    // Keep stats_position() continuous across the jump to another buffer
+    src->shifted += (size_t)old_cur - (size_t)(uintptr_t)(base + cur_off);
+#endif
+    src->buf = base;
+    src->cur = base + cur_off;
+    src->end = base + keep + n;
+    if (src->mark != NULL) {
+        src->mark = base;
     }
+    return n;
+}
 
-    int chars_read = 0;
-    int max_chars = (field_width > 0) ? field_width : INT_MAX;
+static my_scanner_t *scanner_open_reader(my_buffer_reader *reader, int fd) {
+    my_scanner_t *sc = (reader != NULL) ? scanner_new(SCANNER_READER) : NULL;
+    if (sc == NULL) {
+        if (reader != NULL) {
+            reader->close(reader);
+        }
+        return NULL;
+    }
+    sc->reader = reader;
+    sc->src.refill = reader_refill;
+    sc->src.fd = fd;
+    return sc;
+}
 
-    // Check for sign
-    int sign = 1;
-    if ((c == '-' || c == '+') && chars_read < max_chars) {
-        if (c == '-') {
-            sign = -1;
+my_scanner_t *my_scanner_open_uring(int fd, int depth, size_t buffer_size) {
+    return scanner_open_reader(my_uring_reader_open(fd, depth, buffer_size), fd);
+}
+
+my_scanner_t *my_scanner_open_pipeline(int fd, int nbuffers, size_t buffer_size) {
+    return scanner_open_reader(my_thread_reader_open(fd, nbuffers, buffer_size), fd);
+}
+
+// Closing the default scanner is a no-op; nothing else the scanner was
+// given (strings, descriptors, streams) is closed either
+void my_scanner_close(my_scanner_t *sc) {
+    if (sc == NULL || sc == &default_scanner) {
+        return;
+    }
+    if (sc->src.owns_buf) {
+        free(sc->src.buf);
+    }
+    free(sc->spill);
+    my_mmap_close(sc->map);
+    if (sc->reader != NULL) {
+        sc->reader->close(sc->reader);
+    }
+    free(sc);
+}
+
+// Brackets every call on a scanner: FILE* scanners hold the stream lock for
+// the call and hand unread lookahead back to stdio afterwards
+static InputSource *scanner_enter(my_scanner_t *sc) {
+    if (sc->kind == SCANNER_STDIN) {
+        sc->src.file = stdin;
+    }
+    if (sc->src.file != NULL) {
+        flockfile(sc->src.file);
+    }
+    return &sc->src;
+}
+
+static void scanner_leave(my_scanner_t *sc) {
+    if (sc->src.file != NULL) {
+        file_source_finish(&sc->src);
+        funlockfile(sc->src.file);
+    }
+}
+
+// HELPER FUNCTIONS to my_scanf()
+// Whitespace Handling
+// Whitespace means the "C" locale's six isspace() bytes; classifying them
+// directly avoids a locale table lookup per byte.
+static inline int is_space_byte(int c) {
+    return c == ' ' || (unsigned)(c - '\t') <= (unsigned)('\r' - '\t');
+}
+
+// Consumes whitespace from the source, refilling as needed. Leaves the first
+// non-whitespace byte (or '\n' with keep_newline) unread. With keep_newline
+// the span stops at '\n' (the float and %z readers never skip past it).
+// Padded fixed-width input is mostly spaces, so the run is measured by the
+// CPU's widest whitespace kernel and skipped in one step.
+static void skip_whitespace(InputSource *src, int keep_newline) {
+    for (;;) {
+        if (src->cur == src->end && src->refill(src) == 0) {
+            return;
+        }
+        size_t avail = (size_t)(src->end - src->cur);
+        size_t n = my_scanf_active_kernels.span_whitespace(src->cur, avail, keep_newline);
+        src->cur += n;
+        STAT_ADD(src, whitespace_skipped, n);
+        if (n < avail) {
+            return;
         }
-        chars_read++;
-        c = getchar();
     }
+}
 
-    long long value = 0;
-    int read_any_digits = 0;
+// STANDARD TYPE READERS
+// Each read_* function:
+//   1. Skips leading whitespace
+//   2. Checks for optional sign (+/-)
+//   3. Reads digits/characters up to field_width limit
+//   4. Puts back the first non-matching character with ungetc()
+//   5. Returns: 1 (success), 0 (no valid input), -1 (EOF before any input)
 
-    while (c != EOF && isdigit(c) && chars_read < max_chars) {
-        int digit = c - '0';
-        value = value * 10 + digit;
-        read_any_digits = 1;
-        chars_read++;
-        c = getchar();
+// DECIMAL DIGIT KERNEL
+// %d, %ld, %lld and %hd all spend their time folding runs of ASCII digits,
+// so they share one kernel that works on the buffered window directly:
+//   - the run is measured first by the CPU's digit kernel (16 to 64 bytes
+//     per compare, see my_scanf_kernels.c)
+//   - SSE2: whole groups of 16 digits fold with three multiply-add/pack rounds
+//   - SWAR: up to 8 digits fold with three multiplies (no branch per digit)
+//   - scalar tail when fewer than 8 bytes are left in the window
+// Values accumulate modulo 2^64, which gives the same wrap-around the old
+// per-byte loops produced for out-of-range input.
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define HAVE_SWAR_DIGITS 1
+#endif
+
+static const uint64_t powers_of_ten[17] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+    10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+    100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+    100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL
+};
+
+#ifdef HAVE_SWAR_DIGITS
+static inline uint64_t load_u64(const char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Value of the first n (1-8) digits of a little-endian 8-byte word
+static inline uint64_t swar_fold_digits(uint64_t word, int n) {
+    uint64_t v = word - 0x3030303030303030ULL;  // only bytes past n can borrow
+    v <<= 8 * (8 - n);                          // drop them, pad with leading zeros
+    v = (v * 10) + (v >> 8);
+    v = (((v & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+         (((v >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+    return v;
+}
+#endif
+
+#ifdef __SSE2__
+// Value of 16 digits starting at p, most significant first
+static inline uint64_t sse2_fold_16_digits(const char *p) {
+    __m128i d = _mm_sub_epi8(_mm_loadu_si128((const __m128i *)p), _mm_set1_epi8('0'));
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i by_10 = _mm_set_epi16(1, 10, 1, 10, 1, 10, 1, 10);
+    const __m128i by_100 = _mm_set_epi16(1, 100, 1, 100, 1, 100, 1, 100);
+    const __m128i by_10000 = _mm_set_epi16(1, 10000, 1, 10000, 1, 10000, 1, 10000);
+
+    __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(d, zero), by_10);    // 2-digit groups
+    __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(d, zero), by_10);
+    __m128i quads = _mm_madd_epi16(_mm_packs_epi32(lo, hi), by_100);   // 4-digit groups
+    __m128i octs = _mm_madd_epi16(_mm_packs_epi32(quads, quads), by_10000);  // 8-digit groups
+
+    uint64_t high = (uint32_t)_mm_cvtsi128_si32(octs);
+    uint64_t low = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(octs, 4));
+    return high * 100000000ULL + low;
+}
+#endif
+
+// Folds the run of digits at the start of [p, p + len) into *acc
+// (acc = acc * 10^n + digits). Never reads past p + len.
+// Returns n, the number of digits consumed.
+static size_t parse_decimal_digits(const char *p, size_t len, uint64_t *acc) {
+    size_t n = my_scanf_active_kernels.span_digits(p, len);
+    uint64_t value = *acc;
+    size_t i = 0;
+
+#ifdef __SSE2__
+    for (; n - i >= 16; i += 16) {
+        value = value * powers_of_ten[16] + sse2_fold_16_digits(p + i);
     }
+#endif
 
-    // Put back the last character (it wasn't a digit)
-    if (c != EOF) {
-        ungetc(c, stdin);
+#ifdef HAVE_SWAR_DIGITS
+    // Whole words of digits, then the last few digits of the run in one
+    // more word as long as the window still has 8 bytes to load
+    for (; n - i >= 8; i += 8) {
+        value = value * powers_of_ten[8] + swar_fold_digits(load_u64(p + i), 8);
     }
+    if (i < n && len - i >= 8) {
+        int k = (int)(n - i);
+        value = value * powers_of_ten[k] + swar_fold_digits(load_u64(p + i), k);
+        i = n;
+    }
+#endif
 
-    if (read_any_digits) {
-        *d = value * sign;
-        return 1;
+    for (; i < n; i++) {
+        value = value * 10 + (uint64_t)(p[i] - '0');
     }
 
-    return 0;
+    *acc = value;
+    return n;
 }
 
-int read_short(short* d, int field_width) {
+// Shared body of the %d family: skips whitespace, takes an optional sign and
+// then as many digits as the field width allows. On success *result holds
+// the value modulo 2^64 (negated if there was a '-'); callers narrow it.
+static int read_decimal(InputSource *src, unsigned long long *result, int field_width) {
     // Skip leading whitespace
-    int c = getchar();
-    while (c != EOF && isspace(c)) {
-        c = getchar();
-    }
+    skip_whitespace(src, 0);
+    int c = src_getc(src);
 
     // Now c is either a non-whitespace char or EOF
     if (c == EOF) {
@@ -266,314 +1009,448 @@ int read_short(short* d, int field_width) {
     int max_chars = (field_width > 0) ? field_width : INT_MAX;
 
     // Check for sign
-    int sign = 1;
-    if ((c == '-' || c == '+') && chars_read < max_chars) {
-        if (c == '-') {
-            sign = -1;
-        }
+    int negative = 0;
+    if (c == '-' || c == '+') {
+        negative = (c == '-');
         chars_read++;
-        c = getchar();
+    } else {
+        src_ungetc(src, c);  // let the kernel see the first digit
     }
 
-    int value = 0;
+    uint64_t value = 0;
     int read_any_digits = 0;
 
-    while (c != EOF && isdigit(c) && chars_read < max_chars) {
-        int digit = c - '0';
-        value = value * 10 + digit;
-        read_any_digits = 1;
-        chars_read++;
-        c = getchar();
-    }
+    // Run the kernel over whatever is buffered, refilling between windows
+    while (chars_read < max_chars) {
+        if (src->cur == src->end && src->refill(src) == 0) {
+            break;
+        }
+        size_t avail = (size_t)(src->end - src->cur);
+        size_t limit = (size_t)(max_chars - chars_read);
+        if (avail < limit) {
+            limit = avail;
+        }
 
-    // Put back the last character (it wasn't a digit)
-    if (c != EOF) {
-        ungetc(c, stdin);
+        size_t n = parse_decimal_digits(src->cur, limit, &value);
+        src->cur += n;
+        chars_read += (int)n;
+        if (n > 0) {
+            read_any_digits = 1;
+        }
+        if (n < avail) {
+            break;  // stopped on a non-digit (or the width limit)
+        }
     }
 
     if (read_any_digits) {
-        *d = (short)(value * sign);
+        *result = negative ? (unsigned long long)0 - value : value;
         return 1;
     }
 
     return 0;
 }
 
-// Read float with decimal point and optional scientific notation (e/E)
-int read_float(float *value, int field_width) {
-    int c;
-    char buffer[512] = {0};
-    int pos = 0;
-    int max_chars = (field_width > 0) ? field_width : 511;
-
-    // Skip leading whitespace
-    do {
-        c = getchar();
-    } while (isspace(c) && c != '\n');
-
-    if (c == EOF) {
-        return -1;
+// Read signed integer with optional field width limit
+int read_integer(InputSource *src, int* d, int field_width) {
+    unsigned long long value;
+    int result = read_decimal(src, &value, field_width);
+    if (result == 1) {
+        *d = (int)value;
     }
+    return result;
+}
 
-    // Read sign
-    if (c == '+' || c == '-') {
-        buffer[pos++] = (char)c;
-        c = getchar();
+// Variations of the read_integer function for different sizes of integers
+int read_long(InputSource *src, long* d, int field_width) {
+    unsigned long long value;
+    int result = read_decimal(src, &value, field_width);
+    if (result == 1) {
+        *d = (long)value;
     }
+    return result;
+}
 
-    // Check if we have any digits
-    int found_digit = 0;
+int read_long_long(InputSource *src, long long* d, int field_width) {
+    unsigned long long value;
+    int result = read_decimal(src, &value, field_width);
+    if (result == 1) {
+        *d = (long long)value;
+    }
+    return result;
+}
 
-    // Read digits before decimal point
-    while (isdigit(c) && pos < max_chars) {
-        buffer[pos++] = (char)c;
-        found_digit = 1;
-        c = getchar();
+int read_short(InputSource *src, short* d, int field_width) {
+    unsigned long long value;
+    int result = read_decimal(src, &value, field_width);
+    if (result == 1) {
+        *d = (short)value;
     }
+    return result;
+}
 
-    // Read decimal point and digits after
-    if (c == '.' && pos < max_chars) {
-        buffer[pos++] = (char)c;
-        c = getchar();
-        while (isdigit(c) && pos < max_chars) {
-            buffer[pos++] = (char)c;
-            found_digit = 1;
-            c = getchar();
+// FLOATING POINT READERS
+// %f, %lf and %Lf share one scanner that builds the decimal mantissa and
+// exponent while it walks the input, instead of copying the text into a
+// scratch buffer and handing it to strtod() to be scanned a second time.
+//
+// The first 19 significant digits go straight into a 64-bit mantissa (via
+// the same digit kernel as %d). Most inputs then take the Clinger fast path:
+// if the mantissa and the power of ten are both exact doubles, a single
+// multiply or divide is correctly rounded. Only hard cases (more than 19
+// digits, huge/tiny exponents, %Lf) fall back to strtod()/strtof()/strtold(),
+// and they are given a canonical "digits e exponent" string so the result
+// does not depend on the locale's decimal point.
+#define FLOAT_MAX_DIGITS 19     // digits that always fit in a uint64_t
+
+typedef struct {
+    int negative;
+    uint64_t mantissa;          // the first FLOAT_MAX_DIGITS digits
+    int num_digits;             // digits kept (mantissa, then digits[])
+    int exponent;               // value = digits * 10^exponent
+    char digits[512];           // every kept digit, filled only past 19 digits
+} DecimalFloat;
+
+static const double exact_powers_of_ten[23] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Slow path for digits past the 19th: spell the mantissa out once, then
+// keep appending. Past the buffer, integer digits only scale the value and
+// fraction digits are dropped.
+static void float_keep_digit(DecimalFloat *df, int c, int fraction) {
+    if (df->num_digits == FLOAT_MAX_DIGITS) {
+        snprintf(df->digits, sizeof(df->digits), "%019llu", (unsigned long long)df->mantissa);
+    }
+    if (df->num_digits < (int)sizeof(df->digits) - 1) {
+        df->digits[df->num_digits++] = (char)c;
+        if (fraction) {
+            df->exponent--;
         }
+    } else if (!fraction) {
+        df->exponent++;
     }
+}
 
-    // Handle scientific notation (e or E)
-    if ((c == 'e' || c == 'E') && found_digit && pos < max_chars) {
-        buffer[pos++] = (char)c;  // Add the 'e' or 'E'
-        c = getchar();
+// Consumes a run of digits (integer or fraction part) up to the width limit.
+// Returns the number of digits consumed.
+static int scan_float_digits(InputSource *src, DecimalFloat *df, int *pos, int max_chars, int fraction) {
+    int total = 0;
 
-        // Optional sign after e/E
-        if ((c == '+' || c == '-') && pos < max_chars) {
-            buffer[pos++] = (char)c;
-            c = getchar();
+    while (*pos < max_chars) {
+        if (src->cur == src->end && src->refill(src) == 0) {
+            break;
+        }
+        size_t avail = (size_t)(src->end - src->cur);
+        size_t limit = (size_t)(max_chars - *pos);
+        if (avail < limit) {
+            limit = avail;
         }
 
-        // Must have at least one digit after e/E
-        int exp_digit_count = 0;
-        while (isdigit(c) && pos < max_chars) {
-            buffer[pos++] = (char)c;
-            exp_digit_count++;
-            c = getchar();
-        }
-
-        // If no digits after e/E, the 'e' was not part of the number
-        // Put back the last character and remove the 'e' from buffer
-        if (exp_digit_count == 0) {
-            if (c != EOF) ungetc(c, stdin);
-            // Remove the 'e' and any sign that followed it
-            pos = (int)strlen(buffer);
-            while (pos > 0 && (buffer[pos-1] == 'e' || buffer[pos-1] == 'E' ||
-                              buffer[pos-1] == '+' || buffer[pos-1] == '-')) {
-                pos--;
+        size_t n = 0;
+        if (df->num_digits < FLOAT_MAX_DIGITS) {
+            size_t room = (size_t)(FLOAT_MAX_DIGITS - df->num_digits);
+            size_t run = (limit < room) ? limit : room;
+            n = parse_decimal_digits(src->cur, run, &df->mantissa);
+            df->num_digits += (int)n;
+            if (fraction) {
+                df->exponent -= (int)n;
+            }
+            if (n == run && run < limit) {
+                src->cur += n;
+                *pos += (int)n;
+                total += (int)n;
+                continue;  // mantissa is full, carry on in the slow path
+            }
+        } else {
+            while (n < limit && (unsigned char)(src->cur[n] - '0') < 10) {
+                float_keep_digit(df, src->cur[n], fraction);
+                n++;
             }
         }
-    }
 
-    // Put back the character we didn't use
-    if (c != EOF) {
-        ungetc(c, stdin);
-    }
-
-    // Null terminate and convert
-    buffer[pos] = '\0';
-
-    if (!found_digit) {
-        return 0;  // No valid float
+        src->cur += n;
+        *pos += (int)n;
+        total += (int)n;
+        if (n < avail) {
+            break;  // stopped on a non-digit (or the width limit)
+        }
     }
 
-    *value = strtof(buffer, NULL);
-    return 1;
+    return total;
 }
 
-// Variations of the read_float function for different sizes of floats
-int read_double(double *value, int field_width) {
-    int c;
-    char buffer[512] = {0};
-    int pos = 0;
+// Scans [sign] digits [. digits] [e [sign] digits] into df.
+// Returns 1 (success), 0 (no digits), -1 (EOF before any input).
+static int scan_decimal_float(InputSource *src, DecimalFloat *df, int field_width) {
     int max_chars = (field_width > 0) ? field_width : 511;
+    int pos = 0;
 
-    // Skip leading whitespace
-    do {
-        c = getchar();
-    } while (isspace(c) && c != '\n');
+    // Skip leading whitespace (but not newlines)
+    skip_whitespace(src, 1);
+    int c = src_getc(src);
 
     if (c == EOF) {
         return -1;
     }
 
+    df->negative = 0;
+    df->mantissa = 0;
+    df->num_digits = 0;
+    df->exponent = 0;
+
     // Read sign
     if (c == '+' || c == '-') {
-        buffer[pos++] = (char)c;
-        c = getchar();
+        df->negative = (c == '-');
+        pos++;
+    } else {
+        src_ungetc(src, c);
     }
 
-    // Check if we have any digits
-    int found_digit = 0;
-
     // Read digits before decimal point
-    while (isdigit(c) && pos < max_chars) {
-        buffer[pos++] = (char)c;
-        found_digit = 1;
-        c = getchar();
-    }
+    int found_digit = scan_float_digits(src, df, &pos, max_chars, 0) > 0;
+    c = src_getc(src);
 
     // Read decimal point and digits after
     if (c == '.' && pos < max_chars) {
-        buffer[pos++] = (char)c;
-        c = getchar();
-        while (isdigit(c) && pos < max_chars) {
-            buffer[pos++] = (char)c;
+        pos++;
+        if (scan_float_digits(src, df, &pos, max_chars, 1) > 0) {
             found_digit = 1;
-            c = getchar();
         }
+        c = src_getc(src);
     }
 
     // Handle scientific notation (e or E)
     if ((c == 'e' || c == 'E') && found_digit && pos < max_chars) {
-        buffer[pos++] = (char)c;  // Add the 'e' or 'E'
-        c = getchar();
+        pos++;
+        c = src_getc(src);
 
         // Optional sign after e/E
+        int exp_negative = 0;
         if ((c == '+' || c == '-') && pos < max_chars) {
-            buffer[pos++] = (char)c;
-            c = getchar();
+            exp_negative = (c == '-');
+            pos++;
+            c = src_getc(src);
         }
 
-        // Must have at least one digit after e/E
+        // Must have at least one digit after e/E, otherwise the 'e' was not
+        // part of the number and the exponent is simply ignored
         int exp_digit_count = 0;
-        while (isdigit(c) && pos < max_chars) {
-            buffer[pos++] = (char)c;
+        int exp_value = 0;
+        while (c != EOF && (unsigned)(c - '0') < 10 && pos < max_chars) {
+            if (exp_value < 100000) {
+                exp_value = exp_value * 10 + (c - '0');
+            }
             exp_digit_count++;
-            c = getchar();
+            pos++;
+            c = src_getc(src);
         }
-
-        // If no digits after e/E, the 'e' was not part of the number
-        if (exp_digit_count == 0) {
-            if (c != EOF) ungetc(c, stdin);
-            pos = (int)strlen(buffer);
-            while (pos > 0 && (buffer[pos-1] == 'e' || buffer[pos-1] == 'E' ||
-                              buffer[pos-1] == '+' || buffer[pos-1] == '-')) {
-                pos--;
-            }
+        if (exp_digit_count > 0) {
+            df->exponent += exp_negative ? -exp_value : exp_value;
         }
     }
 
     // Put back the character we didn't use
-    if (c != EOF) {
-        ungetc(c, stdin);
+    src_ungetc(src, c);
+
+    return found_digit ? 1 : 0;
+}
+
+// Writes "[-]<digits>e<exponent>" for the strto* fallbacks
+static void decimal_float_text(const DecimalFloat *df, char *text, size_t size) {
+    if (df->num_digits <= FLOAT_MAX_DIGITS) {
+        snprintf(text, size, "%s%llue%d", df->negative ? "-" : "",
+                 (unsigned long long)df->mantissa, df->exponent);
+    } else {
+        snprintf(text, size, "%s%.*se%d", df->negative ? "-" : "",
+                 df->num_digits, df->digits, df->exponent);
+    }
+}
+
+// Clinger's fast path. Returns 1 and sets *out when the mantissa and the
+// power of ten are both exact doubles, so one operation rounds correctly.
+// That needs double arithmetic to really happen in double: x87 evaluation
+// (FLT_EVAL_METHOD 2) rounds twice. Method 16 only widens _Float16, which
+// is what AVX512-FP16 targets report.
+static int decimal_float_fast_path(const DecimalFloat *df, double *out) {
+#if FLT_EVAL_METHOD == 0 || FLT_EVAL_METHOD == 1 || FLT_EVAL_METHOD == 16
+    if (df->num_digits > FLOAT_MAX_DIGITS || df->mantissa > (1ULL << 53)) {
+        return 0;
     }
 
-    // Null terminate and convert
-    buffer[pos] = '\0';
+    uint64_t mantissa = df->mantissa;
+    int exponent = df->exponent;
 
-    if (!found_digit) {
-        return 0;  // No valid float
+    // 123e25 is still easy: move powers of ten into the mantissa while it
+    // stays exact
+    while (exponent > 22 && mantissa != 0 && mantissa <= (1ULL << 53) / 10) {
+        mantissa *= 10;
+        exponent--;
+    }
+    if (exponent < -22 || exponent > 22) {
+        return mantissa == 0 ? (*out = df->negative ? -0.0 : 0.0, 1) : 0;
     }
 
-    *value = strtod(buffer, NULL);
+    double value = (double)mantissa;
+    if (exponent < 0) {
+        value /= exact_powers_of_ten[-exponent];
+    } else {
+        value *= exact_powers_of_ten[exponent];
+    }
+    *out = df->negative ? -value : value;
     return 1;
+#else
+    (void)df;
+    (void)out;
+    return 0;
+#endif
 }
 
-int read_long_double(long double *value, int field_width) {
-    int c;
-    char buffer[512] = {0};
-    int pos = 0;
-    int max_chars = (field_width > 0) ? field_width : 511;
+// Read float with decimal point and optional scientific notation (e/E)
+int read_float(InputSource *src, float *value, int field_width) {
+    DecimalFloat df;
+    int result = scan_decimal_float(src, &df, field_width);
+    if (result != 1) {
+        return result;  // No valid float
+    }
+
+    // The double from the fast path is within half a double ulp of the exact
+    // value, so narrowing it rounds correctly unless it landed exactly on a
+    // halfway point between two floats (low 29 mantissa bits == 1 << 28)
+    double d;
+    if (decimal_float_fast_path(&df, &d)) {
+        uint64_t bits;
+        memcpy(&bits, &d, sizeof(bits));
+        if ((bits & 0x1FFFFFFFULL) != 0x10000000ULL) {
+            *value = (float)d;
+            return 1;
+        }
+    }
 
-    // Skip leading whitespace
-    do {
-        c = getchar();
-    } while (isspace(c) && c != '\n');
+    char text[544];
+    STAT_INC(src, float_slow_paths);
+    decimal_float_text(&df, text, sizeof(text));
+    *value = strtof(text, NULL);
+    return 1;
+}
 
-    if (c == EOF) {
-        return -1;
+// Variations of the read_float function for different sizes of floats
+int read_double(InputSource *src, double *value, int field_width) {
+    DecimalFloat df;
+    int result = scan_decimal_float(src, &df, field_width);
+    if (result != 1) {
+        return result;  // No valid float
     }
 
-    // Read sign
-    if (c == '+' || c == '-') {
-        buffer[pos++] = (char)c;
-        c = getchar();
+    if (decimal_float_fast_path(&df, value)) {
+        return 1;
     }
 
-    // Check if we have any digits
-    int found_digit = 0;
+    char text[544];
+    STAT_INC(src, float_slow_paths);
+    decimal_float_text(&df, text, sizeof(text));
+    *value = strtod(text, NULL);
+    return 1;
+}
 
-    // Read digits before decimal point
-    while (isdigit(c) && pos < max_chars) {
-        buffer[pos++] = (char)c;
-        found_digit = 1;
-        c = getchar();
+int read_long_double(InputSource *src, long double *value, int field_width) {
+    DecimalFloat df;
+    int result = scan_decimal_float(src, &df, field_width);
+    if (result != 1) {
+        return result;  // No valid float
     }
 
-    // Read decimal point and digits after
-    if (c == '.' && pos < max_chars) {
-        buffer[pos++] = (char)c;
-        c = getchar();
-        while (isdigit(c) && pos < max_chars) {
-            buffer[pos++] = (char)c;
-            found_digit = 1;
-            c = getchar();
-        }
-    }
+    // A double-precision fast path would not be correctly rounded for the
+    // wider type, so %Lf always converts through strtold()
+    char text[544];
+    STAT_INC(src, float_slow_paths);
+    decimal_float_text(&df, text, sizeof(text));
+    *value = strtold(text, NULL);
+    return 1;
+}
 
-    // Handle scientific notation (e or E)
-    if ((c == 'e' || c == 'E') && found_digit && pos < max_chars) {
-        buffer[pos++] = (char)c;  // Add the 'e' or 'E'
-        c = getchar();
+// Value of a byte already known to be a hex digit: '0'-'9' keep their low
+// nibble, letters have bit 6 set and need 9 added to theirs
+static inline unsigned hex_digit_value(int c) {
+    return (unsigned)(c & 0xF) + 9 * (unsigned)(c >> 6);
+}
 
-        // Optional sign after e/E
-        if ((c == '+' || c == '-') && pos < max_chars) {
-            buffer[pos++] = (char)c;
-            c = getchar();
-        }
+// HEX DIGIT KERNEL
+// The %x family mirrors the decimal kernel: the run is measured by the CPU's
+// hex kernel, then folded without a branch per digit. Nibbles come from the
+// same rule as hex_digit_value, applied to every byte of a word at once:
+//   - SSE2: 16 digits → nibbles → byte pairs (one shift/or round) → one pack,
+//     and a byte swap puts the most significant pair on top
+//   - SWAR: up to 8 digits fold with three shift/add/mask rounds
+//   - scalar tail when fewer than 8 bytes are left in the window
+// Values accumulate modulo 2^64 like the decimal ones, so 16 digits fill a
+// long long and anything longer keeps its low 64 bits.
+#ifdef HAVE_SWAR_DIGITS
+// Value of the first n (1-8) hex digits of a little-endian 8-byte word
+static inline uint64_t swar_fold_hex_digits(uint64_t word, int n) {
+    uint64_t v = (word & 0x0F0F0F0F0F0F0F0FULL) + 9 * ((word >> 6) & 0x0101010101010101ULL);
+    v <<= 8 * (8 - n);                          // drop bytes past n, pad with leading zeros
+    v = ((v << 4) + (v >> 8)) & 0x00FF00FF00FF00FFULL;    // digit pairs
+    v = ((v << 8) + (v >> 16)) & 0x0000FFFF0000FFFFULL;   // 4-digit groups
+    return ((v & 0xFFFF) << 16) | (v >> 32);
+}
+#endif
+
+#ifdef __SSE2__
+// Value of 16 hex digits starting at p, most significant first
+static inline uint64_t sse2_fold_16_hex_digits(const char *p) {
+    __m128i c = _mm_loadu_si128((const __m128i *)p);
+    __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('9')), _mm_set1_epi8(9));
+    __m128i nibbles = _mm_add_epi8(_mm_and_si128(c, _mm_set1_epi8(0x0F)), letters);
+
+    __m128i pairs = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(nibbles, 4), _mm_set1_epi16(0x00FF)),
+                                 _mm_srli_epi16(nibbles, 8));
+    __m128i bytes = _mm_packus_epi16(pairs, pairs);
+    return __builtin_bswap64((uint64_t)_mm_cvtsi128_si64(bytes));
+}
+#endif
 
-        // Must have at least one digit after e/E
-        int exp_digit_count = 0;
-        while (isdigit(c) && pos < max_chars) {
-            buffer[pos++] = (char)c;
-            exp_digit_count++;
-            c = getchar();
-        }
+// Folds the run of hex digits at the start of [p, p + len) into *acc
+// (acc = acc * 16^n + digits, modulo 2^64). Never reads past p + len.
+// Returns n, the number of digits consumed.
+static size_t parse_hex_digits(const char *p, size_t len, uint64_t *acc) {
+    size_t n = my_scanf_active_kernels.span_hex_digits(p, len);
+    uint64_t value = *acc;
+    size_t i = 0;
 
-        // If no digits after e/E, the 'e' was not part of the number
-        if (exp_digit_count == 0) {
-            if (c != EOF) ungetc(c, stdin);
-            pos = (int)strlen(buffer);
-            while (pos > 0 && (buffer[pos-1] == 'e' || buffer[pos-1] == 'E' ||
-                              buffer[pos-1] == '+' || buffer[pos-1] == '-')) {
-                pos--;
-            }
-        }
+#ifdef __SSE2__
+    // Sixteen more digits shift everything before them out of 64 bits
+    for (; n - i >= 16; i += 16) {
+        value = sse2_fold_16_hex_digits(p + i);
     }
+#endif
 
-    // Put back the character we didn't use
-    if (c != EOF) {
-        ungetc(c, stdin);
+#ifdef HAVE_SWAR_DIGITS
+    for (; n - i >= 8; i += 8) {
+        value = (value << 32) | swar_fold_hex_digits(load_u64(p + i), 8);
     }
+    if (i < n && len - i >= 8) {
+        int k = (int)(n - i);
+        value = (value << (4 * k)) | swar_fold_hex_digits(load_u64(p + i), k);
+        i = n;
+    }
+#endif
 
-    // Null terminate and convert
-    buffer[pos] = '\0';
-
-    if (!found_digit) {
-        return 0;  // No valid float
+    for (; i < n; i++) {
+        value = (value << 4) | hex_digit_value((unsigned char)p[i]);
     }
 
-    *value = strtold(buffer, NULL);
-    return 1;
+    *acc = value;
+    return n;
 }
 
-// Read hexadecimal integer (0-9, a-f, A-F) with optional 0x prefix
-int read_hex_integer(int* x, int field_width) {
+// Shared body of the %x family (hexadecimal with optional sign and 0x
+// prefix). On success *result holds the value modulo 2^64, negated if there
+// was a '-'; callers narrow it to their type.
+static int read_hex(InputSource *src, unsigned long long *result, int field_width) {
     // Skip leading whitespace
-    int c = getchar();
-    while (c != EOF && isspace(c)) {
-        c = getchar();
-    }
+    skip_whitespace(src, 0);
+    int c = src_getc(src);
 
     // Check for EOF
     if (c == EOF) {
@@ -584,69 +1461,98 @@ int read_hex_integer(int* x, int field_width) {
     int max_chars = (field_width > 0) ? field_width : INT_MAX;
 
     // Check for sign
-    int sign = 1;
-    if ((c == '-' || c == '+') && chars_read < max_chars) {
-        if (c == '-') {
-            sign = -1;
-        }
+    int negative = 0;
+    if (c == '-' || c == '+') {
+        negative = (c == '-');
         chars_read++;
-        c = getchar();
+        c = src_getc(src);
     }
 
-    // Check for optional 0x or 0X prefix
+    uint64_t value = 0;
+    int read_any_digits = 0;
+
+    // Check for optional 0x or 0X prefix. The '0' already counts as a digit,
+    // so "0x" with no digits after it reads as 0 with the 'x' consumed, like
+    // glibc (taking the x back as well would need two bytes of pushback).
     if (c == '0' && chars_read < max_chars) {
         chars_read++;
-        int next = getchar();
-        if ((next == 'x' || next == 'X') && chars_read < max_chars) {
+        read_any_digits = 1;
+        c = src_getc(src);
+        if ((c == 'x' || c == 'X') && chars_read < max_chars) {
             chars_read++;
-            c = getchar();  // Move past the 'x' or 'X'
-        } else {
-            // Put back the character after '0'
-            if (next != EOF) {
-                ungetc(next, stdin);
-            }
-            // '0' is a valid hex digit, so c is already '0'
+            c = src_getc(src);  // Move past the 'x' or 'X'
         }
     }
+    src_ungetc(src, c);  // let the kernel see the first digit
 
-    int value = 0;
-    int read_any_digits = 0;
-
-    while (c != EOF && isxdigit(c) && chars_read < max_chars) {
-        int digit;
-        if (isdigit(c)) {
-            digit = c - '0';
-        } else if (c >= 'a' && c <= 'f') {
-            digit = c - 'a' + 10;
-        } else if (c >= 'A' && c <= 'F') {
-            digit = c - 'A' + 10;
-        } else {
+    // Run the kernel over whatever is buffered, refilling between windows
+    while (chars_read < max_chars) {
+        if (src->cur == src->end && src->refill(src) == 0) {
             break;
         }
-        value = value * 16 + digit;
-        read_any_digits = 1;
-        chars_read++;
-        c = getchar();
-    }
+        size_t avail = (size_t)(src->end - src->cur);
+        size_t limit = (size_t)(max_chars - chars_read);
+        if (avail < limit) {
+            limit = avail;
+        }
 
-    // Put back the last character
-    if (c != EOF) {
-        ungetc(c, stdin);
+        size_t n = parse_hex_digits(src->cur, limit, &value);
+        src->cur += n;
+        chars_read += (int)n;
+        if (n > 0) {
+            read_any_digits = 1;
+        }
+        if (n < avail) {
+            break;  // stopped on a non-digit (or the width limit)
+        }
     }
 
     if (read_any_digits) {
-        *x = value * sign;
+        *result = negative ? (unsigned long long)0 - value : value;
         return 1;
     }
 
     return 0;
 }
 
-int read_char(char* c, int field_width) {
+// Read hexadecimal integer (0-9, a-f, A-F) with optional 0x prefix
+int read_hex_integer(InputSource *src, int* x, int field_width) {
+    unsigned long long value;
+    int result = read_hex(src, &value, field_width);
+    if (result == 1) {
+        *x = (int)(unsigned)value;
+    }
+    return result;
+}
+
+// %hx, %lx and %llx: same digits, narrowed to the destination's width
+int read_hex_short(InputSource *src, unsigned short* x, int field_width) {
+    unsigned long long value;
+    int result = read_hex(src, &value, field_width);
+    if (result == 1) {
+        *x = (unsigned short)value;
+    }
+    return result;
+}
+
+int read_hex_long(InputSource *src, unsigned long* x, int field_width) {
+    unsigned long long value;
+    int result = read_hex(src, &value, field_width);
+    if (result == 1) {
+        *x = (unsigned long)value;
+    }
+    return result;
+}
+
+int read_hex_long_long(InputSource *src, unsigned long long* x, int field_width) {
+    return read_hex(src, x, field_width);
+}
+
+int read_char(InputSource *src, char* c, int field_width) {
     int chars_to_read = (field_width > 0) ? field_width : 1;
 
     for (int i = 0; i < chars_to_read; i++) {
-        int ch = getchar();
+        int ch = src_getc(src);
         if (ch == EOF) {
             return (i == 0) ? -1 : 1;  // EOF on first char is error, otherwise success
         }
@@ -656,26 +1562,35 @@ int read_char(char* c, int field_width) {
     return 1;
 }
 
-int read_string(char* s, int max_chars) {
-    int c = getchar();
-    while (c != EOF && isspace(c)) {
-        c = getchar();
-    }
+int read_string(InputSource *src, char* s, int max_chars) {
+    skip_whitespace(src, 0);
+    int c = src_getc(src);
 
     if (c == EOF) {
         return -1;
     }
 
     int count = 0;
-    while (c != EOF && !isspace(c) && count < max_chars - 1) {
+    int limit = max_chars - 1;
+    while (c != EOF && !is_space_byte(c) && count < limit) {
         s[count++] = (char)c;
-        c = getchar();
+
+        // Copy the rest of the run that is already buffered without going
+        // back through src_getc() for every byte
+        const char *p = src->cur;
+        const char *end = src->end;
+        while (p < end && count < limit && !is_space_byte((unsigned char)*p)) {
+            s[count++] = *p++;
+        }
+        src->cur = p;
+
+        c = src_getc(src);
     }
 
     s[count] = '\0';
 
     if (c != EOF) {
-        ungetc(c, stdin);
+        src_ungetc(src, c);
     }
 
     return (count > 0) ? 1 : 0;
@@ -685,12 +1600,14 @@ int read_string(char* s, int max_chars) {
 // These implement non-standard format specifiers as extensions to scanf
 
 // %b - Binary integer reader (accepts 0s and 1s with optional 0b prefix)
-int read_binary_integer(int* b, int field_width) {
+// Shared body of %b, %hb, %lb and %llb. The run of bits is classified and
+// folded by the CPU's binary kernel (a 64-character field is one AVX-512
+// compare and a bit reversal), refilling between windows. On success
+// *result holds the value modulo 2^64, negated if there was a '-'.
+static int read_binary(InputSource *src, unsigned long long *result, int field_width) {
     // Skip leading whitespace
-    int c = getchar();
-    while (c != EOF && isspace(c)) {
-        c = getchar();
-    }
+    skip_whitespace(src, 0);
+    int c = src_getc(src);
 
     // Check for EOF
     if (c == EOF) {
@@ -701,110 +1618,280 @@ int read_binary_integer(int* b, int field_width) {
     int max_chars = (field_width > 0) ? field_width : INT_MAX;
 
     // Check for sign
-    int sign = 1;
-    if ((c == '-' || c == '+') && chars_read < max_chars) {
-        if (c == '-') {
-            sign = -1;
-        }
+    int negative = 0;
+    if (c == '-' || c == '+') {
+        negative = (c == '-');
         chars_read++;
-        c = getchar();
+        c = src_getc(src);
     }
 
-    // Check for optional 0b or 0B prefix
+    uint64_t value = 0;
+    int read_any_digits = 0;
+
+    // Check for optional 0b or 0B prefix; as for %x, the '0' is a digit of
+    // its own and a bare "0b" reads as 0
     if (c == '0' && chars_read < max_chars) {
         chars_read++;
-        int next = getchar();
-        if ((next == 'b' || next == 'B') && chars_read < max_chars) {
+        read_any_digits = 1;
+        c = src_getc(src);
+        if ((c == 'b' || c == 'B') && chars_read < max_chars) {
             chars_read++;
-            c = getchar();  // Move past the 'b' or 'B'
-        } else {
-            // Put back the character after '0'
-            if (next != EOF) {
-                ungetc(next, stdin);
-            }
-            // '0' is a valid binary digit, so continue
+            c = src_getc(src);  // Move past the 'b' or 'B'
         }
     }
+    src_ungetc(src, c);  // let the kernel see the first digit
 
-    int value = 0;
-    int read_any_digits = 0;
-
-    while (c != EOF && (c == '0' || c == '1') && chars_read < max_chars) {
-        int digit = c - '0';
-        value = value * 2 + digit;
-        read_any_digits = 1;
-        chars_read++;
-        c = getchar();
-    }
+    while (chars_read < max_chars) {
+        if (src->cur == src->end && src->refill(src) == 0) {
+            break;
+        }
+        size_t avail = (size_t)(src->end - src->cur);
+        size_t limit = (size_t)(max_chars - chars_read);
+        if (avail < limit) {
+            limit = avail;
+        }
 
-    // Put back the last character
-    if (c != EOF) {
-        ungetc(c, stdin);
+        size_t n = my_scanf_active_kernels.fold_binary_digits(src->cur, limit, &value);
+        src->cur += n;
+        chars_read += (int)n;
+        if (n > 0) {
+            read_any_digits = 1;
+        }
+        if (n < avail) {
+            break;  // stopped on a non-digit (or the width limit)
+        }
     }
 
     if (read_any_digits) {
-        *b = value * sign;  // Apply sign to the magnitude
+        *result = negative ? (unsigned long long)0 - value : value;
         return 1;
     }
 
     return 0;
 }
 
+int read_binary_integer(InputSource *src, int* b, int field_width) {
+    unsigned long long value;
+    int result = read_binary(src, &value, field_width);
+    if (result == 1) {
+        *b = (int)value;
+    }
+    return result;
+}
+
+// %hb, %lb and %llb: bitmaps wider than an int land in long / long long
+int read_binary_short(InputSource *src, short* b, int field_width) {
+    unsigned long long value;
+    int result = read_binary(src, &value, field_width);
+    if (result == 1) {
+        *b = (short)value;
+    }
+    return result;
+}
+
+int read_binary_long(InputSource *src, long* b, int field_width) {
+    unsigned long long value;
+    int result = read_binary(src, &value, field_width);
+    if (result == 1) {
+        *b = (long)value;
+    }
+    return result;
+}
+
+int read_binary_long_long(InputSource *src, long long* b, int field_width) {
+    unsigned long long value;
+    int result = read_binary(src, &value, field_width);
+    if (result == 1) {
+        *b = (long long)value;
+    }
+    return result;
+}
+
+// LINE BUFFERS
+// %q and %z copy the rest of the line into one of three places:
+//   - the caller's array: data/cap/max are the array and its size, and a
+//     longer line is cut at max - 1 bytes with the rest left unread
+//   - a malloc'd string (%mq, %mz): it starts small and doubles, up to max
+//   - nowhere (suppressed fields, data == NULL): the line is only skipped
+// The readers find the newline with memchr over whole window spans, so a
+// 4 KB field costs a few calls rather than a refill check per byte.
+typedef struct {
+    char *data;
+    size_t len;          // bytes stored so far (not counting the NUL)
+    size_t cap;          // bytes allocated at data
+    size_t max;          // most bytes the line may take, NUL included
+    int alloc;           // data is ours to realloc (%mq, %mz)
+    int failed;          // ran out of memory while growing
+} LineBuffer;
+
+#define LINE_ALLOC_INITIAL 64
+
+static size_t line_grow(LineBuffer *lb, size_t want) {
+    size_t cap = lb->cap * 2;
+    if (cap < lb->len + want + 1) {
+        cap = lb->len + want + 1;
+    }
+    if (cap > lb->max) {
+        cap = lb->max;
+    }
+    char *data = realloc(lb->data, cap);
+    if (data == NULL) {
+        lb->failed = 1;
+        return 0;
+    }
+    lb->data = data;
+    lb->cap = cap;
+    return want;
+}
+
+// How many of the next want bytes fit (growing the allocation if allowed).
+// The caller's array never grows; once it is full the answer is 0.
+static inline size_t line_room(LineBuffer *lb, size_t want) {
+    size_t room = (lb->len + 1 < lb->max) ? lb->max - lb->len - 1 : 0;
+    if (want > room) {
+        want = room;
+    }
+    if (lb->data != NULL && lb->len + want + 1 > lb->cap) {
+        return lb->alloc ? line_grow(lb, want) : 0;
+    }
+    return want;
+}
+
+// The same shift for a single byte (offset already reduced to 0-25)
+static inline char cipher_byte(unsigned char c, int offset, int invert_case) {
+    unsigned char lower = c | 0x20;
+    if (lower < 'a' || lower > 'z') {
+        return (char)c;
+    }
+    int shifted = lower - 'a' + offset;
+    if (shifted >= 26) {
+        shifted -= 26;
+    }
+    return (char)(('a' + shifted) ^ ((c & 0x20) ^ (invert_case ? 0x20 : 0) ^ 0x20));
+}
+
 // %q - Caesar cipher reader with rotation offset
 // Reads text until newline, applies Caesar cipher with given offset
 // Format: %Nq where N is rotation amount (e.g., %3q rotates by 3)
 // %!Nq includes case inversion (uppercase ↔ lowercase after rotation)
 // Non-letters (spaces, punctuation, numbers) pass through unchanged
-int read_cipher(char* q, int offset, int invert_case, int max_size) {
-    int c = getchar();
+// Each window span up to the newline is shifted in one translate_cipher
+// call (a table lookup, or 16-32 bytes per SIMD step).
+static int read_cipher_line(InputSource *src, LineBuffer *lb, int offset, int invert_case) {
+    offset = ((offset % 26) + 26) % 26;
 
     // Read until newline or EOF
-    int count = 0;
+    while (!lb->failed) {
+        if (src->cur == src->end && src->refill(src) == 0) {
+            break;
+        }
+        size_t avail = (size_t)(src->end - src->cur);
+        size_t n;
+        int stop;
+
+        if (avail < 16) {
+            // Short windows (the 1-byte stdin window) are not worth a
+            // memchr and a kernel call
+            size_t room = line_room(lb, avail);
+            n = 0;
+            while (n < room && src->cur[n] != '\n') {
+                if (lb->data != NULL) {
+                    lb->data[lb->len + n] = cipher_byte((unsigned char)src->cur[n], offset, invert_case);
+                }
+                n++;
+            }
+            stop = (n < avail);
+        } else {
+            // The newline is left unread for the next directive
+            const char *nl = memchr(src->cur, '\n', avail);
+            size_t want = (nl != NULL) ? (size_t)(nl - src->cur) : avail;
+            n = line_room(lb, want);
+            if (lb->data != NULL) {
+                my_scanf_active_kernels.translate_cipher(lb->data + lb->len, src->cur, n, offset, invert_case);
+            }
+            stop = (nl != NULL || n < want);
+        }
+        src->cur += n;
+        lb->len += n;
+        if (stop) {
+            break;
+        }
+    }
 
-    while (c != EOF && c != '\n' && count < max_size - 1) {
-        char result;
+    // Null-terminate
+    if (lb->data != NULL) {
+        lb->data[lb->len] = '\0';
+    }
 
-        if (c >= 'a' && c <= 'z') {
-            // Lowercase letter - cipher it
-            int pos = c - 'a';
-            pos = (pos + offset) % 26;
-            if (pos < 0) pos += 26;
-            result = (char)('a' + pos);
+    if (lb->failed) {
+        return 0;
+    }
+    return (lb->len > 0) ? 1 : -1;
+}
 
-            // Invert case if needed
-            if (invert_case) {
-                result = (char)(result - 'a' + 'A');  // Convert to uppercase
-            }
-        } else if (c >= 'A' && c <= 'Z') {
-            // Uppercase letter - cipher it
-            int pos = c - 'A';
-            pos = (pos + offset) % 26;
-            if (pos < 0) pos += 26;
-            result = (char)('A' + pos);
-
-            // Invert case if needed
-            if (invert_case) {
-                result = (char)(result - 'A' + 'a');  // Convert to lowercase
+int read_cipher(InputSource *src, char* q, int offset, int invert_case, int max_size) {
+    LineBuffer lb = { q, 0, (size_t)max_size, (size_t)max_size, 0, 0 };
+    return read_cipher_line(src, &lb, offset, invert_case);
+}
+
+// Whole-stream %q: large reads, one translate_cipher pass over each buffer
+// in place, and the buffer written back out in full.
+#define TEXT_STREAM_BUFFER (1024 * 1024)
+
+static int write_all(int fd, const char *p, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
             }
-        } else {
-            // Non-letter (space, punctuation, numbers, etc.)
-            result = (char)c;
+            return -1;
         }
-
-        q[count] = result;
-        count++;
-        c = getchar();
+        p += n;
+        len -= (size_t)n;
     }
+    return 0;
+}
 
-    // Put back newline if we stopped at one
-    if (c == '\n') {
-        ungetc(c, stdin);
+long long my_cipher_stream(int in_fd, int out_fd, int offset, int invert_case) {
+    char *buf = aligned_alloc(SOURCE_BUFFER_ALIGN, TEXT_STREAM_BUFFER);
+    if (buf == NULL) {
+        return -1;
     }
+    offset = ((offset % 26) + 26) % 26;
+
+    long long total = 0;
+    int eof = 0;
+    while (!eof) {
+        // Fill the whole buffer before writing, so a pipe that delivers
+        // 4 KiB at a time still gets megabyte writes
+        size_t len = 0;
+        while (len < TEXT_STREAM_BUFFER) {
+            ssize_t n = read(in_fd, buf + len, TEXT_STREAM_BUFFER - len);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0) {
+                free(buf);
+                return -1;
+            }
+            if (n == 0) {
+                eof = 1;
+                break;
+            }
+            len += (size_t)n;
+        }
 
-    // Null-terminate
-    q[count] = '\0';
+        my_scanf_active_kernels.translate_cipher(buf, buf, len, offset, invert_case);
+        if (write_all(out_fd, buf, len) != 0) {
+            free(buf);
+            return -1;
+        }
+        total += (long long)len;
+    }
 
-    return (count > 0) ? 1 : -1;
+    free(buf);
+    return total;
 }
 
 // %z - "Gen Z" text reader that appends slang suffix
@@ -813,415 +1900,1804 @@ int read_cipher(char* q, int offset, int invert_case, int max_size) {
 //   %z   → appends " lol"
 //   %!z  → appends " lol!"
 //   %!hz → appends " haha!"
-int read_gen_z(char* z, int max_size, int exclaim, const char *length_mod) {
-    int c = getchar();
-
-    // Skip leading whitespace
-    while (c != EOF && isspace(c) && c != '\n') {
-        c = getchar();
-    }
-
-    // Determine what to append
-    const char *suffix;
+static const char *gen_z_suffix(int exclaim, const char *length_mod) {
     if (exclaim && length_mod[0] == 'h') {
-        suffix = " haha!";  // %!hz
+        return " haha!";  // %!hz
     } else if (exclaim) {
-        suffix = " lol!";    // %!z
-    } else {
-        suffix = " lol";     // %z
+        return " lol!";    // %!z
     }
+    return " lol";         // %z
+}
 
-    int suffix_len = (int)strlen(suffix);
+static int read_gen_z_line(InputSource *src, LineBuffer *lb, const char *suffix) {
+    size_t suffix_len = strlen(suffix);
 
-    // If we hit newline or EOF immediately, return just the suffix (without leading space)
-    if (c == '\n' || c == EOF) {
-        if (max_size >= suffix_len) {
-            strcpy(z, suffix + 1);  // Skip leading space
-            return 1;
-        }
+    // Even an empty line needs room for the bare suffix
+    if (lb->max < suffix_len) {
         return 0;
     }
 
-    // Read until newline or EOF
-    int count = 0;
-    int last_non_space = -1;  // Track position of last non-whitespace char
+    // Skip leading whitespace (but not the newline that ends the line)
+    skip_whitespace(src, 1);
+
+    // The text may only use what the suffix leaves over
+    size_t max = lb->max;
+    lb->max = (max > suffix_len) ? max - suffix_len : 1;
 
-    while (c != EOF && c != '\n' && count < max_size - suffix_len - 1) {
-        z[count] = (char)c;
-        if (!isspace(c)) {
-            last_non_space = count;
+    // Read until newline or EOF, remembering where the last non-whitespace
+    // byte went so trailing whitespace can be trimmed
+    size_t keep = 0;
+    while (!lb->failed) {
+        if (src->cur == src->end && src->refill(src) == 0) {
+            break;
+        }
+        size_t avail = (size_t)(src->end - src->cur);
+        if (avail < 16) {
+            // Short windows (the 1-byte stdin window): the rest of the line
+            // goes byte by byte through src_getc, with no memchr or memcpy
+            char *out = lb->data;
+            size_t len = lb->len;
+            int c;
+            while ((c = src_getc(src)) != EOF && c != '\n') {
+                if (len + 1 >= lb->max || (out != NULL && len + 1 >= lb->cap)) {
+                    lb->len = len;
+                    if (line_room(lb, 1) == 0) {
+                        break;   // full, or out of memory
+                    }
+                    out = lb->data;
+                }
+                if (out != NULL) {
+                    out[len] = (char)c;
+                    if (!is_space_byte(c)) {
+                        keep = len + 1;
+                    }
+                }
+                len++;
+            }
+            lb->len = len;
+            // Put back the newline (or the byte that did not fit)
+            if (c != EOF) {
+                src_ungetc(src, c);
+            }
+            break;
         }
-        count++;
-        c = getchar();
-    }
 
-    // Put back newline if we stopped at one
-    if (c == '\n') {
-        ungetc(c, stdin);
-    }
+        const char *nl = memchr(src->cur, '\n', avail);
+        size_t want = (nl != NULL) ? (size_t)(nl - src->cur) : avail;
+        size_t n = line_room(lb, want);
 
-    // Trim trailing whitespace
-    if (last_non_space >= 0) {
-        count = last_non_space + 1;
-    } else {
-        // All whitespace - return just suffix (without leading space)
-        strcpy(z, suffix + 1);
+        if (lb->data != NULL) {
+            memcpy(lb->data + lb->len, src->cur, n);
+            size_t k = n;
+            while (k > 0 && is_space_byte((unsigned char)src->cur[k - 1])) {
+                k--;
+            }
+            if (k > 0) {
+                keep = lb->len + k;
+            }
+        }
+        src->cur += n;
+        lb->len += n;
+        if (nl != NULL || n < want) {
+            break;   // the newline is left unread
+        }
+    }
+    lb->max = max;
+    if (lb->failed) {
+        return 0;
+    }
+    if (lb->data == NULL) {
         return 1;
     }
 
-    // Append suffix
-    strcpy(z + count, suffix);
+    // Trim trailing whitespace; an empty or all-whitespace line is just the
+    // suffix (without its leading space)
+    lb->len = keep;
+    if (keep == 0) {
+        suffix++;
+        suffix_len--;
+    }
 
+    // Append suffix
+    if (line_room(lb, suffix_len) < suffix_len) {
+        return 0;
+    }
+    memcpy(lb->data + lb->len, suffix, suffix_len + 1);
+    lb->len += suffix_len;
     return 1;
 }
 
-// MAIN SCANF IMPLEMENTATION
-// Custom implementation of scanf() with additional format specifiers
-// Standard specifiers: %d, %ld, %lld, %hd, %f, %lf, %Lf, %x, %s, %c
-// Custom specifiers:   %b (binary), %z (gen-z text), %q (cipher)
-// Modifiers:           * (suppress), ! (custom modifier), field width
-// Format string processing:
-//   - '%%' → matches literal '%' in input
-//   - Whitespace in format → skips any amount of whitespace in input
-//   - Literal characters → must match exactly in input
-//   - Format specifiers → parsed and dispatched to appropriate reader
-//
-// Return value: Number of successfully assigned items (not suppressed)
-//               Returns EOF (-1) if EOF encountered before any assignment
-int my_scanf(const char *format, ...) {
-    va_list args;
-    va_start(args, format);
-    int assigned_count = 0;
-    int i = 0;
+int read_gen_z(InputSource *src, char* z, int max_size, int exclaim, const char *length_mod) {
+    LineBuffer lb = { z, 0, (size_t)max_size, (size_t)max_size, 0, 0 };
+    return read_gen_z_line(src, &lb, gen_z_suffix(exclaim, length_mod));
+}
 
-    // Main parsing loop - process format string character by character
-    while (format[i] != '\0') {
-        // Format specifier found - parse and process it
-        if (format[i] == '%') {
-            i++;
-            if (format[i] == '\0') {
-                break;
-            }
+// Whole-stream %z: every line of in_fd comes out the way read_gen_z would
+// return it, followed by the newline it had. Lines are trimmed where they
+// sit in the buffer and go out as iovecs - the line slice, then a static
+// suffix that carries the newline - batched into one writev, so line bytes
+// are not copied. Only a line cut off at the end of a buffer is moved to the
+// front before the next read (and the buffer grows if the line fills it).
+#define GENZ_STREAM_IOVECS 1024
 
-            // Handle %% as a literal '%'
-            if (format[i] == '%') {
-                // Skip any whitespace before the % if needed
-                int c = getchar();
-                if (c != '%') {
-                    // Mismatch - the literal % is missing
-                    if (c != EOF) {
-                        ungetc(c, stdin);
-                    }
-                    va_end(args);
-                    return assigned_count;  // Return what we've assigned so far
-                }
-                // Successfully matched the literal %
-                i++;  // Move past the second '%'
+typedef struct {
+    int fd;
+    struct iovec iov[GENZ_STREAM_IOVECS];
+    int count;
+    long long total;
+} GenzBatch;
+
+static int genz_flush(GenzBatch *batch) {
+    struct iovec *iov = batch->iov;
+    int count = batch->count;
+    batch->count = 0;
+    while (count > 0) {
+        ssize_t n = writev(batch->fd, iov, count);
+        if (n < 0) {
+            if (errno == EINTR) {
                 continue;
             }
+            return -1;
+        }
+        batch->total += n;
+        // Step over what went out; a partial write leaves us mid-iovec
+        while (count > 0 && (size_t)n >= iov->iov_len) {
+            n -= (ssize_t)iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= (size_t)n;
+        }
+    }
+    return 0;
+}
 
-            // Parse the format specification
-            FormatSpecifier spec;
-            int consumed = parse_format_specifier(&format[i], &spec);
-            i += consumed;
-
-
-            // Handle based on specifier (ignore modifiers for now)
-            switch (spec.specifier) {
-                case 'd': {
-                    int result;
-
-                    // Check for length modifiers
-                    if (strcmp(spec.length_mod, "ll") == 0) {
-                        if (spec.suppress) {
-                            long long temp;
-                            result = read_long_long(&temp, spec.field_width);
-                        } else {
-                            long long *ptr = va_arg(args, long long*);
-                            result = read_long_long(ptr, spec.field_width);
-                            if (result == 1) {
-                                assigned_count++;
-                            }
-                        }
-                    } else if (strcmp(spec.length_mod, "l") == 0) {
-                        if (spec.suppress) {
-                            long temp;
-                            result = read_long(&temp, spec.field_width);
-                        } else {
-                            long *ptr = va_arg(args, long*);
-                            result = read_long(ptr, spec.field_width);
-                            if (result == 1) {
-                                assigned_count++;
-                            }
-                        }
-                    } else if (strcmp(spec.length_mod, "h") == 0) {
-                        if (spec.suppress) {
-                            short temp;
-                            result = read_short(&temp, spec.field_width);
-                        } else {
-                            short *ptr = va_arg(args, short*);
-                            result = read_short(ptr, spec.field_width);
-                            if (result == 1) {
-                                assigned_count++;
-                            }
-                        }
-                    } else {
-                        // Default: regular int
-                        if (spec.suppress) {
-                            int temp;
-                            result = read_integer(&temp, spec.field_width);
-                        } else {
-                            int *ptr = va_arg(args, int*);
-                            result = read_integer(ptr, spec.field_width);
-                            if (result == 1) {
-                                assigned_count++;
-                            }
-                        }
-                    }
+// Queues one line (without its newline) as read_gen_z would return it
+static int genz_line(GenzBatch *batch, const char *p, size_t len, const char *suffix, int newline) {
+    size_t lead = my_scanf_active_kernels.span_whitespace(p, len, 1);
+    while (len > lead && is_space_byte((unsigned char)p[len - 1])) {
+        len--;
+    }
+    // Empty and all-whitespace lines are just the suffix, without its space
+    size_t suffix_len = strlen(suffix) - (newline ? 0 : 1);
+    if (len == lead) {
+        suffix++;
+        suffix_len--;
+    } else {
+        batch->iov[batch->count].iov_base = (void *)(p + lead);
+        batch->iov[batch->count].iov_len = len - lead;
+        batch->count++;
+    }
+    batch->iov[batch->count].iov_base = (void *)suffix;
+    batch->iov[batch->count].iov_len = suffix_len;
+    batch->count++;
+    return (batch->count > GENZ_STREAM_IOVECS - 2) ? genz_flush(batch) : 0;
+}
 
-                    // Handle EOF/failure
-                    if (result == -1) {
-                        va_end(args);
-                        return (assigned_count == 0) ? -1 : assigned_count;
-                    } else if (result == 0) {
-                        va_end(args);
-                        return assigned_count;
-                    }
-                    break;
-                }
+long long my_genz_stream(int in_fd, int out_fd, my_genz_mode mode) {
+    const char *suffix;
+    switch (mode) {
+        case MY_GENZ_LOL:         suffix = " lol\n";   break;   // %z
+        case MY_GENZ_LOL_EXCLAIM: suffix = " lol!\n";  break;   // %!z
+        case MY_GENZ_HAHA:        suffix = " haha!\n"; break;   // %!hz
+        default:                  return -1;
+    }
+
+    size_t cap = TEXT_STREAM_BUFFER;
+    char *buf = malloc(cap);
+    GenzBatch *batch = malloc(sizeof(*batch));
+    if (buf == NULL || batch == NULL) {
+        free(buf);
+        free(batch);
+        return -1;
+    }
+    batch->fd = out_fd;
+    batch->count = 0;
+    batch->total = 0;
 
-                case 'c': {
-                    int result;
-                    int num_chars = (spec.field_width > 0) ? spec.field_width : 1;
-
-                    if (spec.suppress) {
-                        // Read but don't store - use a temporary buffer
-                        char temp[256];
-                        result = read_char(temp, num_chars);
-                    } else {
-                        // Normal case - get pointer from va_arg and store
-                        char *ptr = va_arg(args, char*);
-                        result = read_char(ptr, num_chars);
-                        if (result == 1) {
-                            assigned_count++;
-                        }
-                    }
+    size_t len = 0;
+    int eof = 0, failed = 0;
+    while (!eof && !failed) {
+        while (len < cap) {
+            ssize_t n = read(in_fd, buf + len, cap - len);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                eof = 1;
+                failed = (n < 0);
+                break;
+            }
+            len += (size_t)n;
+        }
+        if (failed) {
+            break;
+        }
 
-                    // Handle EOF/failure
-                    if (result == -1) {
-                        va_end(args);
-                        return (assigned_count == 0) ? -1 : assigned_count;
-                    }
-                    break;
-                }
+        size_t start = 0;
+        const char *nl;
+        while (!failed && (nl = memchr(buf + start, '\n', len - start)) != NULL) {
+            failed = genz_line(batch, buf + start, (size_t)(nl - (buf + start)), suffix, 1) != 0;
+            start = (size_t)(nl - buf) + 1;
+        }
+        // A last line without a newline still gets its suffix
+        if (!failed && eof && start < len) {
+            failed = genz_line(batch, buf + start, len - start, suffix, 0) != 0;
+            start = len;
+        }
+        // The iovecs point into buf, so they go out before it is reused
+        if (failed || genz_flush(batch) != 0) {
+            failed = 1;
+            break;
+        }
 
-                case 's': {
-                    char buffer[256];  // Temp buffer for suppressed reads
-                    int max_size = spec.field_width > 0 ? spec.field_width + 1 : 256;
-                    int result;
-
-                    if (spec.suppress) {
-                        // Read but don't store
-                        result = read_string(buffer, max_size);
-                        // Don't increment assigned_count
-                        // Don't call va_arg
-                    } else {
-                        // Normal case - get pointer from va_arg and store
-                        char *ptr = va_arg(args, char*);
-                        result = read_string(ptr, max_size);
-                        if (result == 1) {
-                            assigned_count++;
-                        }
-                    }
+        memmove(buf, buf + start, len - start);
+        len -= start;
+        if (len == cap) {
+            char *grown = realloc(buf, cap * 2);
+            if (grown == NULL) {
+                failed = 1;
+                break;
+            }
+            buf = grown;
+            cap *= 2;
+        }
+    }
 
-                    // Handle EOF/failure
-                    if (result == -1) {
-                        va_end(args);
-                        return (assigned_count == 0) ? -1 : assigned_count;
-                    } else if (result == 0) {
-                        va_end(args);
-                        return assigned_count;
-                    }
-                    break;
-                }
+    long long total = batch->total;
+    free(buf);
+    free(batch);
+    return failed ? -1 : total;
+}
 
-                case 'f': {
-                    int result;
-
-                    // Check for length modifiers
-                    if (strcmp(spec.length_mod, "L") == 0) {
-                        if (spec.suppress) {
-                            long double temp;
-                            result = read_long_double(&temp, spec.field_width);
-                        } else {
-                            long double *ptr = va_arg(args, long double*);
-                            result = read_long_double(ptr, spec.field_width);
-                            if (result == 1) {
-                                assigned_count++;
-                            }
-                        }
-                    } else if (strcmp(spec.length_mod, "l") == 0) {
-                        if (spec.suppress) {
-                            double temp;
-                            result = read_double(&temp, spec.field_width);
-                        } else {
-                            double *ptr = va_arg(args, double*);
-                            result = read_double(ptr, spec.field_width);
-                            if (result == 1) {
-                                assigned_count++;
-                            }
-                        }
-                    } else {
-                        // Default: regular float
-                        if (spec.suppress) {
-                            float temp;
-                            result = read_float(&temp, spec.field_width);
-                        } else {
-                            float *ptr = va_arg(args, float*);
-                            result = read_float(ptr, spec.field_width);
-                            if (result == 1) {
-                                assigned_count++;
-                            }
-                        }
-                    }
+// %v - Zero-copy view reader
+// Stores a my_scanf_view { ptr, len } that points into the input itself, so
+// nothing is copied or NUL-terminated. Only memory windows (my_sscanf and
+// mapped files) keep their bytes in place after the call; fd and FILE*
+// windows are reused by the next refill, so there %v is a matching failure.
+// Variants:
+//   %v   → the next whitespace-delimited token, like %s (width limits it)
+//   %!v  → the rest of the line, read like %z (leading and trailing
+//          whitespace trimmed, the newline left unread)
+int read_view(InputSource *src, my_scanf_view *v, int field_width, int whole_line) {
+    if (src->refill != mem_refill) {
+        return 0;
+    }
 
-                    // Handle EOF/failure
-                    if (result == -1) {
-                        va_end(args);
-                        return (assigned_count == 0) ? -1 : assigned_count;
-                    } else if (result == 0) {
-                        va_end(args);
-                        return assigned_count;
-                    }
-                    break;
-                }
+    skip_whitespace(src, whole_line);
+    const char *start = src->cur;
+    const char *end = src->end;
+    if (start == end) {
+        return -1;
+    }
 
-                case 'x': {
-                    int result;
-
-                    if (spec.suppress) {
-                        // Read but don't store
-                        int temp;
-                        result = read_hex_integer(&temp, spec.field_width);
-                    } else {
-                        // Normal case - get pointer from va_arg and store
-                        int *ptr = va_arg(args, int*);
-                        result = read_hex_integer(ptr, spec.field_width);
-                        if (result == 1) {
-                            assigned_count++;
-                        }
-                    }
+    size_t limit = (field_width > 0) ? (size_t)field_width : (size_t)(end - start);
+    if (limit < (size_t)(end - start)) {
+        end = start + limit;
+    }
 
-                    // Handle EOF/failure
-                    if (result == -1) {
-                        va_end(args);
-                        return (assigned_count == 0) ? -1 : assigned_count;
-                    } else if (result == 0) {
-                        va_end(args);
-                        return assigned_count;
-                    }
-                    break;
-                }
+    const char *p = start;
+    if (whole_line) {
+        const char *nl = memchr(start, '\n', (size_t)(end - start));
+        p = (nl != NULL) ? nl : end;
+        src->cur = p;
+        while (p > start && is_space_byte((unsigned char)p[-1])) {
+            p--;
+        }
+    } else {
+        while (p < end && !is_space_byte((unsigned char)*p)) {
+            p++;
+        }
+        src->cur = p;
+    }
 
-                case 'b': {
-                    int result;
-
-                    if (spec.suppress) {
-                        // Read but don't store
-                        int temp;
-                        result = read_binary_integer(&temp, spec.field_width);
-                    } else {
-                        // Normal case - get pointer from va_arg and store
-                        int *ptr = va_arg(args, int*);
-                        result = read_binary_integer(ptr, spec.field_width);
-                        if (result == 1) {
-                            assigned_count++;
-                        }
-                    }
+    v->ptr = start;
+    v->len = (size_t)(p - start);
+    return 1;
+}
 
-                    // Handle EOF/failure
-                    if (result == -1) {
-                        va_end(args);
-                        return (assigned_count == 0) ? -1 : assigned_count;
-                    } else if (result == 0) {
-                        va_end(args);
-                        return assigned_count;
-                    }
-                    break;
+// CONVERSION ADAPTERS
+// Every conversion is reached through one uniform signature so a compiled
+// program can store the reader it needs as a plain function pointer instead
+// of re-deciding on every call. dest is NULL for suppressed ('*') fields.
+// Adapters normalise the readers' return values to:
+//    1 → value converted (and stored unless suppressed)
+//    0 → matching failure, stop and return what was assigned so far
+//   -1 → input failure (EOF), return EOF if nothing was assigned yet
+typedef int (*ConvertFn)(InputSource *src, const FormatSpecifier *spec, void *dest);
+
+static int convert_int(InputSource *src, const FormatSpecifier *spec, void *dest) {
+    int temp;
+    return read_integer(src, dest ? (int *)dest : &temp, spec->field_width);
+}
+
+static int convert_long(InputSource *src, const FormatSpecifier *spec, void *dest) {
+    long temp;
+    return read_long(src, dest ? (long *)dest : &temp, spec->field_width);
+}
+
+static int convert_long_long(InputSource *src, const FormatSpecifier *spec, void *dest) {
+    long long temp;
+    return read_long_long(src, dest ? (long long *)dest : &temp, spec->field_width);
+}
+
+static int convert_short(InputSource *src, const FormatSpecifier *spec, void *dest) {
+    short temp;
+    return read_short(src, dest ? (short *)dest : &temp, spec->field_width);
+}
+
+static int convert_float(InputSource *src, const FormatSpecifier *spec, void *dest) {
+    float temp;
+    return read_float(src, dest ? (float *)dest : &temp, spec->field_width);
+}
+
+static int convert_double(InputSource *src, const FormatSpecifier *spec, void *dest) {
+    double temp;
+    return read_double(src, dest ? (double *)dest : &temp, spec->field_width);
+}
+
+static int convert_long_double(InputSource *src, const FormatSpecifier *spec, void *dest) {
+    long double temp;
+    return read_long_double(src, dest ? (long double *)dest : &temp, spec->field_width);
+}
+
+static int convert_hex(InputSource *src, const FormatSpecifier *spec, void *dest) {
+    int temp;
+    return read_hex_integer(src, dest ? (int *)dest : &temp, spec->field_width);
+}
+
+static int convert_hex_short(InputSource *src, const FormatSpecifier *spec, void *dest) {
+    unsigned short temp;
+    return read_hex_short(src, dest ? (unsigned short *)dest : &temp, spec->field_width);
+}
+
+static int convert_hex_long(InputSource *src, const FormatSpecifier *spec, void *dest) {
+    unsigned long temp;
+    return read_hex_long(src, dest ? (unsigned long *)dest : &temp, spec->field_width);
+}
+
+static int convert_hex_long_long(InputSource *src, const FormatSpecifier *spec, void *dest) {
+    unsigned long long temp;
+    return read_hex_long_long(src, dest ? (unsigned long long *)dest : &temp, spec->field_width);
+}
+
+static int convert_binary(InputSource *src, const FormatSpecifier *spec, void *dest) {
+    int temp;
+    return read_binary_integer(src, dest ? (int *)dest : &temp, spec->field_width);
+}
+
+static int convert_binary_short(InputSource *src, const FormatSpecifier *spec, void *dest) {
+    short temp;
+    return read_binary_short(src, dest ? (short *)dest : &temp, spec->field_width);
+}
+
+static int convert_binary_long(InputSource *src, const FormatSpecifier *spec, void *dest) {
+    long temp;
+    return read_binary_long(src, dest ? (long *)dest : &temp, spec->field_width);
+}
+
+static int convert_binary_long_long(InputSource *src, const FormatSpecifier *spec, void *dest) {
+    long long temp;
+    return read_binary_long_long(src, dest ? (long long *)dest : &temp, spec->field_width);
+}
+
+static int convert_char(InputSource *src, const FormatSpecifier *spec, void *dest) {
+    char temp[256];
+    int num_chars = (spec->field_width > 0) ? spec->field_width : 1;
+    if (dest == NULL && num_chars > (int)sizeof(temp)) {
+        num_chars = (int)sizeof(temp);
+    }
+    return read_char(src, dest ? (char *)dest : temp, num_chars);
+}
+
+static int convert_string(InputSource *src, const FormatSpecifier *spec, void *dest) {
+    char temp[256];
+    int max_size = (spec->field_width > 0) ? spec->field_width + 1 : 256;
+    if (dest == NULL && max_size > (int)sizeof(temp)) {
+        max_size = (int)sizeof(temp);
+    }
+    return read_string(src, dest ? (char *)dest : temp, max_size);
+}
+
+// Sets up where a %q or %z line goes: the caller's array of size bytes, a
+// fresh allocation for 'm' (limit bytes at most, 0 = no limit), or nowhere
+// for suppressed fields. Returns -1 if the allocation fails.
+static int line_target(LineBuffer *lb, const FormatSpecifier *spec, void *dest, size_t size, size_t limit) {
+    memset(lb, 0, sizeof(*lb));
+    lb->max = (limit > 0) ? limit : SIZE_MAX;
+    if (dest == NULL) {
+        return 0;
+    }
+    if (!spec->alloc) {
+        lb->data = dest;
+        lb->cap = lb->max = size;
+        return 0;
+    }
+    lb->cap = (lb->max < LINE_ALLOC_INITIAL) ? lb->max : LINE_ALLOC_INITIAL;
+    lb->alloc = 1;
+    lb->data = malloc(lb->cap);
+    return (lb->data == NULL) ? -1 : 0;
+}
+
+// %mq and %mz hand the caller the string only if the conversion succeeded
+static int line_finish(LineBuffer *lb, const FormatSpecifier *spec, void *dest, int result) {
+    if (spec->alloc && dest != NULL) {
+        if (result == 1) {
+            *(char **)dest = lb->data;
+        } else {
+            free(lb->data);
+        }
+    }
+    return result;
+}
+
+static int convert_gen_z(InputSource *src, const FormatSpecifier *spec, void *dest) {
+    // The width is the whole buffer, suffix and NUL included
+    size_t size = (spec->field_width > 0) ? (size_t)spec->field_width : 256;
+    LineBuffer lb;
+    if (line_target(&lb, spec, dest, size, (size_t)spec->field_width) != 0) {
+        return -1;
+    }
+    // read_gen_z only fails when it cannot even fit the bare suffix
+    int result = read_gen_z_line(src, &lb, gen_z_suffix(spec->exclaim, spec->length_mod));
+    return line_finish(&lb, spec, dest, (result == 0) ? -1 : result);
+}
+
+static int convert_cipher(InputSource *src, const FormatSpecifier *spec, void *dest) {
+    // The field width is the shift offset for %q, not a size limit
+    LineBuffer lb;
+    if (line_target(&lb, spec, dest, 256, 0) != 0) {
+        return -1;
+    }
+    return line_finish(&lb, spec, dest, read_cipher_line(src, &lb, spec->field_width, spec->exclaim));
+}
+
+static int convert_view(InputSource *src, const FormatSpecifier *spec, void *dest) {
+    my_scanf_view temp;
+    return read_view(src, dest ? (my_scanf_view *)dest : &temp, spec->field_width, spec->exclaim);
+}
+
+// Picks the reader for a parsed specifier, taking the length modifier into
+// account. Returns NULL for specifiers we don't support (they are skipped).
+static ConvertFn resolve_converter(const FormatSpecifier *spec) {
+    const char *len = spec->length_mod;
+
+    // Only the line conversions know how to allocate their result
+    if (spec->alloc && spec->specifier != 'q' && spec->specifier != 'z') {
+        return NULL;
+    }
+
+    switch (spec->specifier) {
+        case 'd':
+            if (len[0] == 'l' && len[1] == 'l') return convert_long_long;
+            if (len[0] == 'l') return convert_long;
+            if (len[0] == 'h') return convert_short;
+            return convert_int;
+        case 'f':
+            if (len[0] == 'L') return convert_long_double;
+            if (len[0] == 'l') return convert_double;
+            return convert_float;
+        case 'x':
+            if (len[0] == 'l' && len[1] == 'l') return convert_hex_long_long;
+            if (len[0] == 'l') return convert_hex_long;
+            if (len[0] == 'h') return convert_hex_short;
+            return convert_hex;
+        case 'b':
+            if (len[0] == 'l' && len[1] == 'l') return convert_binary_long_long;
+            if (len[0] == 'l') return convert_binary_long;
+            if (len[0] == 'h') return convert_binary_short;
+            return convert_binary;
+        case 'c': return convert_char;
+        case 's': return convert_string;
+        case 'z': return convert_gen_z;
+        case 'q': return convert_cipher;
+        case 'v': return convert_view;
+        default:  return NULL;
+    }
+}
+
+// Size of the object a conversion stores into. The bulk column front ends
+// use it as the row stride of each column array; character conversions
+// without a width fall back to the same 256-byte rows my_scanf assumes.
+static size_t converter_dest_size(const FormatSpecifier *spec) {
+    const char *len = spec->length_mod;
+    int width = spec->field_width;
+
+    switch (spec->specifier) {
+        case 'd':
+            if (len[0] == 'l' && len[1] == 'l') return sizeof(long long);
+            if (len[0] == 'l') return sizeof(long);
+            if (len[0] == 'h') return sizeof(short);
+            return sizeof(int);
+        case 'f':
+            if (len[0] == 'L') return sizeof(long double);
+            if (len[0] == 'l') return sizeof(double);
+            return sizeof(float);
+        case 'x':
+            if (len[0] == 'l' && len[1] == 'l') return sizeof(unsigned long long);
+            if (len[0] == 'l') return sizeof(unsigned long);
+            if (len[0] == 'h') return sizeof(unsigned short);
+            return sizeof(int);
+        case 'b':
+            if (len[0] == 'l' && len[1] == 'l') return sizeof(long long);
+            if (len[0] == 'l') return sizeof(long);
+            if (len[0] == 'h') return sizeof(short);
+            return sizeof(int);
+        case 'c': return (width > 0) ? (size_t)width : 1;
+        case 's': return (width > 0) ? (size_t)width + 1 : 256;
+        case 'z': return spec->alloc ? sizeof(char *) : (width > 0) ? (size_t)width : 256;
+        case 'q': return spec->alloc ? sizeof(char *) : 256;
+        case 'v': return sizeof(my_scanf_view);
+        default:  return 0;
+    }
+}
+
+#ifdef MY_SCANF_STATS
+// Which MY_SCANF_READ_* counters a conversion is charged to
+static int converter_stat_id(const FormatSpecifier *spec) {
+    const char *len = spec->length_mod;
+
+    switch (spec->specifier) {
+        case 'd':
+            if (len[0] == 'l' && len[1] == 'l') return MY_SCANF_READ_LONG_LONG;
+            if (len[0] == 'l') return MY_SCANF_READ_LONG;
+            if (len[0] == 'h') return MY_SCANF_READ_SHORT;
+            return MY_SCANF_READ_INTEGER;
+        case 'f':
+            if (len[0] == 'L') return MY_SCANF_READ_LONG_DOUBLE;
+            if (len[0] == 'l') return MY_SCANF_READ_DOUBLE;
+            return MY_SCANF_READ_FLOAT;
+        case 'x': return MY_SCANF_READ_HEX;
+        case 'b': return MY_SCANF_READ_BINARY;
+        case 'c': return MY_SCANF_READ_CHAR;
+        case 's': return MY_SCANF_READ_STRING;
+        case 'z': return MY_SCANF_READ_GEN_Z;
+        case 'q': return MY_SCANF_READ_CIPHER;
+        default:  return MY_SCANF_READ_VIEW;
+    }
+}
+
+// Position in the input that survives src_compact() sliding the window
+static inline uint64_t stats_position(const InputSource *src) {
+    return (uint64_t)(uintptr_t)src->cur + src->shifted;
+}
+#endif
+
+// FORMAT PROGRAMS
+// A format string is a sequence of three kinds of operations:
+//   OP_LITERAL    → a run of bytes that must match the input exactly
+//                   ('%%' becomes a one-byte run holding '%')
+//   OP_WHITESPACE → any whitespace in the format, skips whitespace in input
+//   OP_CONVERT    → a '%' specifier with its reader already resolved
+// my_scanf decodes these one at a time straight off the format string;
+// my_scanf_compile decodes them once into a my_scanf_program that can then be
+// executed any number of times with no format parsing at all.
+typedef enum {
+    OP_LITERAL,
+    OP_WHITESPACE,
+    OP_CONVERT
+} OpKind;
+
+typedef struct {
+    OpKind kind;
+    const char *literal;   // OP_LITERAL: bytes to match (not NUL-terminated)
+    int literal_len;
+    FormatSpecifier spec;  // OP_CONVERT
+    ConvertFn convert;     // OP_CONVERT
+    size_t dest_size;      // OP_CONVERT: bytes written through the destination
+#ifdef MY_SCANF_STATS
+    int stat_id;           // OP_CONVERT: MY_SCANF_READ_* counters to charge
+#endif
+} ScanOp;
+
+struct my_scanf_program {
+    int num_ops;
+    int num_dests;         // non-suppressed conversions, i.e. pointers consumed
+    char *format;          // private copy, OP_LITERAL points into it
+    ScanOp *ops;
+};
+
+// Decodes the next operation starting at format[*i] and advances *i past it.
+// Returns 0 once the format is exhausted (or ends in a lone '%').
+static int next_scan_op(const char *format, int *i, ScanOp *op) {
+    for (;;) {
+        const char *p = &format[*i];
+
+        if (*p == '\0') {
+            return 0;
+        }
+
+        if (*p == '%') {
+            if (p[1] == '\0') {
+                return 0;
+            }
+            // Handle %% as a literal '%'
+            if (p[1] == '%') {
+                op->kind = OP_LITERAL;
+                op->literal = p + 1;
+                op->literal_len = 1;
+                *i += 2;
+                return 1;
+            }
+
+            *i += 1 + parse_format_specifier(p + 1, &op->spec);
+            op->convert = resolve_converter(&op->spec);
+            if (op->convert == NULL) {
+                continue;  // Unknown specifier - skip it
+            }
+            op->kind = OP_CONVERT;
+            op->dest_size = converter_dest_size(&op->spec);
+#ifdef MY_SCANF_STATS
+            op->stat_id = converter_stat_id(&op->spec);
+#endif
+            return 1;
+        }
+
+        if (isspace((unsigned char)*p)) {
+            // Any run of format whitespace behaves like a single one
+            while (isspace((unsigned char)format[*i])) {
+                (*i)++;
+            }
+            op->kind = OP_WHITESPACE;
+            return 1;
+        }
+
+        // Literal run up to the next '%' or whitespace
+        int len = 0;
+        while (p[len] != '\0' && p[len] != '%' && !isspace((unsigned char)p[len])) {
+            len++;
+        }
+        op->kind = OP_LITERAL;
+        op->literal = p;
+        op->literal_len = len;
+        *i += len;
+        return 1;
+    }
+}
+
+// Destinations for converted values: either the caller's variadic pointers
+// or an array of pointers (used by the program and bulk front ends)
+typedef struct {
+    va_list args;
+    void **array;
+} DestCursor;
+
+static void *next_dest(DestCursor *dests) {
+    if (dests->array != NULL) {
+        return *dests->array++;
+    }
+    return va_arg(dests->args, void *);
+}
+
+// Runs one operation. Returns 1 to keep going, or 0 to stop with *result
+// set to the value my_scanf should return.
+static int run_scan_op(InputSource *src, const ScanOp *op, DestCursor *dests,
+                       int *assigned_count, int *result) {
+    switch (op->kind) {
+        case OP_LITERAL:
+            for (int k = 0; k < op->literal_len; k++) {
+                int c = src_getc(src);
+                if (c != (unsigned char)op->literal[k]) {
+                    // Mismatch - stop processing
+                    src_ungetc(src, c);
+                    STAT_INC(src, literal_mismatches);
+                    *result = *assigned_count;
+                    return 0;
                 }
+            }
+            return 1;
 
-                case 'z': {
-                    char buffer[256];  // Temp buffer for suppressed reads
-                    int max_size = spec.field_width > 0 ? spec.field_width : 256;
-                    int result;
-
-                    if (spec.suppress) {
-                        result = read_gen_z(buffer, max_size, spec.exclaim, spec.length_mod);
-                    } else {
-                        char *ptr = va_arg(args, char*);
-                        result = read_gen_z(ptr, max_size, spec.exclaim, spec.length_mod);
-                        if (result == 1) {
-                            assigned_count++;
-                        }
-                    }
+        case OP_WHITESPACE:
+            // Format has whitespace - skip whitespace in input
+            skip_whitespace(src, 0);
+            return 1;
 
-                    // Handle EOF - will handle whitespaces so don't worry
-                    if (result == 0) {
-                        va_end(args);
-                        return (assigned_count == 0) ? -1 : assigned_count;
-                    }
-                    break;
+        case OP_CONVERT: {
+            void *dest = op->spec.suppress ? NULL : next_dest(dests);
+#ifdef MY_SCANF_STATS
+            my_scanf_reader_stats *reader = &source_stats(src)->readers[op->stat_id];
+            uint64_t start = stats_clock();
+            int status = op->convert(src, &op->spec, dest);
+            reader->cycles += stats_clock() - start;
+            reader->calls++;
+            reader->matching_failures += (status == 0);
+            reader->input_failures += (status == -1);
+#else
+            int status = op->convert(src, &op->spec, dest);
+#endif
+
+            if (status == 1) {
+                if (dest != NULL) {
+                    (*assigned_count)++;
                 }
+                return 1;
+            }
+            // Handle EOF/failure
+            if (status == -1) {
+                *result = (*assigned_count == 0) ? -1 : *assigned_count;
+            } else {
+                *result = *assigned_count;
+            }
+            return 0;
+        }
+    }
+    return 1;
+}
 
-                case 'q': {
-                    char buffer[256];  // Temp buffer for suppressed reads
-                    int max_size = 256;
-                    int offset = spec.field_width;
-                    int result;
-
-                    if (spec.suppress) {
-                        result = read_cipher(buffer, offset, spec.exclaim, max_size);
-                    } else {
-                        char *ptr = va_arg(args, char*);
-                        result = read_cipher(ptr, offset, spec.exclaim, max_size);
-                        if (result == 1) {
-                            assigned_count++;
-                        }
-                    }
+// MAIN SCANF IMPLEMENTATION
+// Custom implementation of scanf() with additional format specifiers
+// Standard specifiers: %d, %ld, %lld, %hd, %f, %lf, %Lf, %x, %s, %c
+// Custom specifiers:   %b (binary), %z (gen-z text), %q (cipher), %v (view)
+// Modifiers:           * (suppress), ! (custom modifier), field width
+// Format string processing:
+//   - '%%' → matches literal '%' in input
+//   - Whitespace in format → skips any amount of whitespace in input
+//   - Literal characters → must match exactly in input
+//   - Format specifiers → parsed and dispatched to appropriate reader
+//
+// Return value: Number of successfully assigned items (not suppressed)
+//               Returns EOF (-1) if EOF encountered before any assignment
+//
+// my_vscanf_source is the shared engine; the public front ends below only
+// differ in which InputSource they build.
+static int my_vscanf_source(InputSource *src, const char *format, va_list args) {
+    DestCursor dests = { .array = NULL };
+    va_copy(dests.args, args);
 
-                    // Handle EOF
-                    if (result == -1) {
-                        va_end(args);
-                        return (assigned_count == 0) ? -1 : assigned_count;
-                    }
-                    break;
+    int assigned_count = 0;
+    int result = 0;
+    int i = 0;
+    ScanOp op;
+#ifdef MY_SCANF_STATS
+    uint64_t start = stats_position(src);
+    STAT_INC(src, scans);
+#endif
+
+    // Main parsing loop - decode and run one operation at a time
+    int running = 1;
+    while (running && next_scan_op(format, &i, &op)) {
+        running = run_scan_op(src, &op, &dests, &assigned_count, &result);
+    }
+
+    va_end(dests.args);
+    STAT_ADD(src, bytes_consumed, stats_position(src) - start);
+    return running ? assigned_count : result;
+}
+
+// Same engine, but over an already compiled program. If completed is not
+// NULL it is set to 1 only when every operation ran to the end.
+static int run_program(InputSource *src, const my_scanf_program *prog, DestCursor *dests,
+                       int *completed) {
+    int assigned_count = 0;
+    int result = 0;
+
+#ifdef MY_SCANF_STATS
+    uint64_t start = stats_position(src);
+    STAT_INC(src, scans);
+#endif
+
+    int running = 1;
+    for (int k = 0; running && k < prog->num_ops; k++) {
+        running = run_scan_op(src, &prog->ops[k], dests, &assigned_count, &result);
+    }
+    if (completed != NULL) {
+        *completed = running;
+    }
+    STAT_ADD(src, bytes_consumed, stats_position(src) - start);
+    return running ? assigned_count : result;
+}
+
+static int my_vscan_program(InputSource *src, const my_scanf_program *prog, va_list args) {
+    DestCursor dests = { .array = NULL };
+    va_copy(dests.args, args);
+    int result = run_program(src, prog, &dests, NULL);
+    va_end(dests.args);
+    return result;
+}
+
+// BULK COLUMN SCANNING
+// Runs the program once per record and stores field k of record i at
+// cols[k] + i * (size of field k), i.e. straight into struct-of-arrays
+// columns. There is no va_arg dispatch and no format parsing per record;
+// stepping to the next row is one pointer add per column.
+
+// Frees the %mq / %mz strings among the first assigned fields of a row
+static void release_row(const my_scanf_program *prog, void **row, int assigned) {
+    int col = 0;
+    for (int k = 0; k < prog->num_ops && col < assigned; k++) {
+        const ScanOp *op = &prog->ops[k];
+        if (op->kind == OP_CONVERT && !op->spec.suppress) {
+            if (op->spec.alloc) {
+                free(*(char **)row[col]);
+            }
+            col++;
+        }
+    }
+}
+
+// Returns the number of records that matched completely. A record that fails
+// part way is not counted, and any %mq / %mz strings it stored are freed.
+static int scan_columns(InputSource *src, const my_scanf_program *prog, int n, void *cols[]) {
+    int num_cols = prog->num_dests;
+    void *stack_row[16];
+    size_t stack_sizes[16];
+    void **row = stack_row;
+    size_t *sizes = stack_sizes;
+
+    if (num_cols > 16) {
+        row = malloc((size_t)num_cols * sizeof(*row));
+        sizes = malloc((size_t)num_cols * sizeof(*sizes));
+        if (row == NULL || sizes == NULL) {
+            free(row);
+            free(sizes);
+            return 0;
+        }
+    }
+
+    int col = 0;
+    for (int k = 0; k < prog->num_ops; k++) {
+        const ScanOp *op = &prog->ops[k];
+        if (op->kind == OP_CONVERT && !op->spec.suppress) {
+            row[col] = cols[col];
+            sizes[col] = op->dest_size;
+            col++;
+        }
+    }
+
+    int records = 0;
+    while (records < n) {
+        DestCursor dests = { .array = row };
+        int completed;
+        int assigned = run_program(src, prog, &dests, &completed);
+        if (!completed) {
+            // A partial record is not handed back, so neither are its strings
+            release_row(prog, row, assigned);
+            break;
+        }
+        records++;
+        for (col = 0; col < num_cols; col++) {
+            row[col] = (char *)row[col] + sizes[col];
+        }
+    }
+
+    if (row != stack_row) {
+        free(row);
+        free(sizes);
+    }
+    return records;
+}
+
+// FORMAT COMPILATION
+// Returns NULL if the format is NULL or memory runs out
+my_scanf_program *my_scanf_compile(const char *format) {
+    if (format == NULL) {
+        return NULL;
+    }
+
+    my_scanf_program *prog = calloc(1, sizeof(*prog));
+    if (prog == NULL) {
+        return NULL;
+    }
+    prog->format = strdup(format);
+    if (prog->format == NULL) {
+        free(prog);
+        return NULL;
+    }
+
+    // First pass counts operations, second pass fills them in
+    ScanOp op;
+    int i = 0;
+    int count = 0;
+    while (next_scan_op(prog->format, &i, &op)) {
+        count++;
+    }
+
+    prog->ops = calloc((size_t)(count > 0 ? count : 1), sizeof(ScanOp));
+    if (prog->ops == NULL) {
+        free(prog->format);
+        free(prog);
+        return NULL;
+    }
+
+    i = 0;
+    while (next_scan_op(prog->format, &i, &prog->ops[prog->num_ops])) {
+        const ScanOp *added = &prog->ops[prog->num_ops];
+        if (added->kind == OP_CONVERT && !added->spec.suppress) {
+            prog->num_dests++;
+        }
+        prog->num_ops++;
+    }
+
+    return prog;
+}
+
+void my_scanf_free(my_scanf_program *prog) {
+    if (prog == NULL) {
+        return;
+    }
+    free(prog->ops);
+    free(prog->format);
+    free(prog);
+}
+
+int my_vscanf(const char *format, va_list args) {
+    return my_scanner_vscanf(my_scanner_default(), format, args);
+}
+
+int my_scanf(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int result = my_vscanf(format, args);
+    va_end(args);
+    return result;
+}
+
+int my_vfscanf(FILE *stream, const char *format, va_list args) {
+    char window[1];
+    InputSource src;
+    file_source_init(&src, stream, window, sizeof(window));
+
+    flockfile(stream);
+    int result = my_vscanf_source(&src, format, args);
+    file_source_finish(&src);
+    funlockfile(stream);
+    return result;
+}
+
+int my_fscanf(FILE *stream, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int result = my_vfscanf(stream, format, args);
+    va_end(args);
+    return result;
+}
+
+int my_vsscanf(const char *str, const char *format, va_list args) {
+    InputSource src = { .cur = str, .end = str + strlen(str), .refill = mem_refill };
+    return my_vscanf_source(&src, format, args);
+}
+
+int my_sscanf(const char *str, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int result = my_vsscanf(str, format, args);
+    va_end(args);
+    return result;
+}
+
+int my_vfdscanf(int fd, const char *format, va_list args) {
+    InputSource *src = fd_source_get(fd);
+    if (src == NULL) {
+        return EOF;
+    }
+    return my_vscanf_source(src, format, args);
+}
+
+int my_fdscanf(int fd, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int result = my_vfdscanf(fd, format, args);
+    va_end(args);
+    return result;
+}
+
+int my_vmmscanf(my_scanf_mmap *m, const char *format, va_list args) {
+    return my_vscanf_source(&m->src, format, args);
+}
+
+int my_mmscanf(my_scanf_mmap *m, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int result = my_vmmscanf(m, format, args);
+    va_end(args);
+    return result;
+}
+
+// COMPILED PROGRAM FRONT ENDS
+// Same sources as above, but the format was parsed once by my_scanf_compile
+int my_vscanf_exec(const my_scanf_program *prog, va_list args) {
+    return my_scanner_vexec(my_scanner_default(), prog, args);
+}
+
+int my_scanf_exec(const my_scanf_program *prog, ...) {
+    va_list args;
+    va_start(args, prog);
+    int result = my_vscanf_exec(prog, args);
+    va_end(args);
+    return result;
+}
+
+int my_vfscanf_exec(FILE *stream, const my_scanf_program *prog, va_list args) {
+    char window[1];
+    InputSource src;
+    file_source_init(&src, stream, window, sizeof(window));
+
+    flockfile(stream);
+    int result = my_vscan_program(&src, prog, args);
+    file_source_finish(&src);
+    funlockfile(stream);
+    return result;
+}
+
+int my_fscanf_exec(FILE *stream, const my_scanf_program *prog, ...) {
+    va_list args;
+    va_start(args, prog);
+    int result = my_vfscanf_exec(stream, prog, args);
+    va_end(args);
+    return result;
+}
+
+int my_vsscanf_exec(const char *str, const my_scanf_program *prog, va_list args) {
+    InputSource src = { .cur = str, .end = str + strlen(str), .refill = mem_refill };
+    return my_vscan_program(&src, prog, args);
+}
+
+int my_sscanf_exec(const char *str, const my_scanf_program *prog, ...) {
+    va_list args;
+    va_start(args, prog);
+    int result = my_vsscanf_exec(str, prog, args);
+    va_end(args);
+    return result;
+}
+
+int my_vfdscanf_exec(int fd, const my_scanf_program *prog, va_list args) {
+    InputSource *src = fd_source_get(fd);
+    if (src == NULL) {
+        return EOF;
+    }
+    return my_vscan_program(src, prog, args);
+}
+
+int my_fdscanf_exec(int fd, const my_scanf_program *prog, ...) {
+    va_list args;
+    va_start(args, prog);
+    int result = my_vfdscanf_exec(fd, prog, args);
+    va_end(args);
+    return result;
+}
+
+int my_vmmscanf_exec(my_scanf_mmap *m, const my_scanf_program *prog, va_list args) {
+    return my_vscan_program(&m->src, prog, args);
+}
+
+int my_mmscanf_exec(my_scanf_mmap *m, const my_scanf_program *prog, ...) {
+    va_list args;
+    va_start(args, prog);
+    int result = my_vmmscanf_exec(m, prog, args);
+    va_end(args);
+    return result;
+}
+
+// INTERNAL HELPERS (declared in my_scanf_internal.h)
+int my_scanf_program_num_dests(const my_scanf_program *prog) {
+    return prog->num_dests;
+}
+
+size_t my_scanf_program_dest_size(const my_scanf_program *prog, int k) {
+    for (int i = 0; i < prog->num_ops; i++) {
+        const ScanOp *op = &prog->ops[i];
+        if (op->kind == OP_CONVERT && !op->spec.suppress && k-- == 0) {
+            return op->dest_size;
+        }
+    }
+    return 0;
+}
+
+int my_scanf_program_has_views(const my_scanf_program *prog) {
+    for (int i = 0; i < prog->num_ops; i++) {
+        const ScanOp *op = &prog->ops[i];
+        if (op->kind == OP_CONVERT && !op->spec.suppress && op->spec.specifier == 'v') {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int my_scanf_program_allocates(const my_scanf_program *prog) {
+    for (int i = 0; i < prog->num_ops; i++) {
+        const ScanOp *op = &prog->ops[i];
+        if (op->kind == OP_CONVERT && !op->spec.suppress && op->spec.alloc) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int my_scan_columns_range(const char *buf, size_t len, const my_scanf_program *prog,
+                          int n, void *cols[], size_t *consumed) {
+    InputSource src = { .cur = buf, .end = buf + len, .refill = mem_refill };
+    int records = scan_columns(&src, prog, n, cols);
+    *consumed = (size_t)(src.cur - buf);
+    return records;
+}
+
+const char *my_mmap_data(const my_scanf_mmap *m, size_t *len) {
+    *len = m->len;
+    return m->data;
+}
+
+// BULK COLUMN FRONT ENDS
+int my_scan_columns(const char *format, int n, void *cols[]) {
+    return my_scanner_scan_columns(my_scanner_default(), format, n, cols);
+}
+
+int my_fscan_columns(FILE *stream, const char *format, int n, void *cols[]) {
+    my_scanf_program *prog = my_scanf_compile(format);
+    if (prog == NULL) {
+        return 0;
+    }
+
+    char window[1];
+    InputSource src;
+    file_source_init(&src, stream, window, sizeof(window));
+
+    flockfile(stream);
+    int records = scan_columns(&src, prog, n, cols);
+    file_source_finish(&src);
+    funlockfile(stream);
+
+    my_scanf_free(prog);
+    return records;
+}
+
+int my_sscan_columns(const char *str, const char *format, int n, void *cols[]) {
+    my_scanf_program *prog = my_scanf_compile(format);
+    if (prog == NULL) {
+        return 0;
+    }
+
+    InputSource src = { .cur = str, .end = str + strlen(str), .refill = mem_refill };
+    int records = scan_columns(&src, prog, n, cols);
+
+    my_scanf_free(prog);
+    return records;
+}
+
+int my_fdscan_columns(int fd, const char *format, int n, void *cols[]) {
+    InputSource *src = fd_source_get(fd);
+    my_scanf_program *prog = my_scanf_compile(format);
+    if (src == NULL || prog == NULL) {
+        my_scanf_free(prog);
+        return 0;
+    }
+
+    int records = scan_columns(src, prog, n, cols);
+
+    my_scanf_free(prog);
+    return records;
+}
+
+int my_mmscan_columns(my_scanf_mmap *m, const char *format, int n, void *cols[]) {
+    my_scanf_program *prog = my_scanf_compile(format);
+    if (prog == NULL) {
+        return 0;
+    }
+
+    int records = scan_columns(&m->src, prog, n, cols);
+
+    my_scanf_free(prog);
+    return records;
+}
+
+// SCANNER FRONT ENDS
+int my_scanner_vscanf(my_scanner_t *sc, const char *format, va_list args) {
+    int result = my_vscanf_source(scanner_enter(sc), format, args);
+    scanner_leave(sc);
+    return result;
+}
+
+int my_scanner_scanf(my_scanner_t *sc, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int result = my_scanner_vscanf(sc, format, args);
+    va_end(args);
+    return result;
+}
+
+int my_scanner_vexec(my_scanner_t *sc, const my_scanf_program *prog, va_list args) {
+    int result = my_vscan_program(scanner_enter(sc), prog, args);
+    scanner_leave(sc);
+    return result;
+}
+
+int my_scanner_exec(my_scanner_t *sc, const my_scanf_program *prog, ...) {
+    va_list args;
+    va_start(args, prog);
+    int result = my_scanner_vexec(sc, prog, args);
+    va_end(args);
+    return result;
+}
+
+int my_scanner_scan_columns(my_scanner_t *sc, const char *format, int n, void *cols[]) {
+    my_scanf_program *prog = my_scanf_compile(format);
+    if (prog == NULL) {
+        return 0;
+    }
+
+    int records = scan_columns(scanner_enter(sc), prog, n, cols);
+    scanner_leave(sc);
+
+    my_scanf_free(prog);
+    return records;
+}
+
+// SCANNER CHECKPOINTS
+// A checkpoint is just a mark in the scanner's window: refills keep every
+// byte from the mark onwards (growing the buffer if they fill it), so a
+// rollback only has to move cur back. Memory and mapped scanners keep their
+// whole input anyway and never copy anything.
+void my_scanner_checkpoint(my_scanner_t *sc) {
+    sc->src.mark = sc->src.cur;
+}
+
+void my_scanner_rollback(my_scanner_t *sc) {
+    if (sc->src.mark != NULL) {
+        sc->src.cur = sc->src.mark;
+    }
+}
+
+// A FILE* scanner keeps its lookahead while a checkpoint is open; handing the
+// byte back now leaves the stream in sync with stdio again
+void my_scanner_commit(my_scanner_t *sc) {
+    scanner_enter(sc);
+    sc->src.mark = NULL;
+    scanner_leave(sc);
+}
+
+// MULTI-FORMAT MATCHING
+// A my_scanf_set is a trie over the operations of its formats. Literal runs
+// are split into one node per byte, so formats that start with the same text
+// share the nodes for it, and a line picks between literal branches by
+// looking at its next byte. Conversions and whitespace are shared when they
+// are identical; where formats diverge at a conversion (%d vs %s) each branch
+// is tried in turn from the same position in the line, which is buffered
+// whole for exactly that.
+//
+// Children are kept in the order their first format was added, and every
+// node knows the lowest format index below it. The walk records the first
+// format that completes and from then on skips any branch that could only
+// produce a later one, so the answer is the one a loop of sscanf calls over
+// the list would give.
+//
+// A shared conversion stores through the destination of the lowest format
+// below it; when a different format wins, those values are copied over.
+typedef struct AnyNode AnyNode;
+
+struct AnyNode {
+    ScanOp op;             // OP_LITERAL nodes hold a single byte
+    int ordinal;           // OP_CONVERT: destination index in every format through here
+    int terminal;          // lowest format that ends here, or INT_MAX
+    int min_format;        // lowest format anywhere below (and at) this node
+    AnyNode **children;
+    int num_children;
+    int cap_children;
+};
+
+struct my_scanf_set {
+    AnyNode root;
+    my_scanf_program **progs;  // literal ops point into their format copies
+    int num_progs;
+    int max_dests;         // most conversions on any path, sizes the walk's stack
+};
+
+static int same_scan_op(const ScanOp *a, const ScanOp *b) {
+    if (a->kind != b->kind) {
+        return 0;
+    }
+    switch (a->kind) {
+        case OP_LITERAL:
+            return a->literal[0] == b->literal[0];
+        case OP_WHITESPACE:
+            return 1;
+        case OP_CONVERT:
+            return a->spec.specifier == b->spec.specifier &&
+                   a->spec.field_width == b->spec.field_width &&
+                   strcmp(a->spec.length_mod, b->spec.length_mod) == 0 &&
+                   a->spec.suppress == b->spec.suppress &&
+                   a->spec.exclaim == b->spec.exclaim;
+    }
+    return 0;
+}
+
+// Returns the child of node for op, adding it for format f if there is none
+// yet, or NULL if memory runs out
+static AnyNode *any_child(AnyNode *node, const ScanOp *op, int ordinal, int f) {
+    for (int k = 0; k < node->num_children; k++) {
+        if (same_scan_op(&node->children[k]->op, op)) {
+            return node->children[k];
+        }
+    }
+    if (node->num_children == node->cap_children) {
+        int cap = (node->cap_children > 0) ? node->cap_children * 2 : 4;
+        AnyNode **children = realloc(node->children, (size_t)cap * sizeof(*children));
+        if (children == NULL) {
+            return NULL;
+        }
+        node->children = children;
+        node->cap_children = cap;
+    }
+    AnyNode *child = calloc(1, sizeof(*child));
+    if (child == NULL) {
+        return NULL;
+    }
+    child->op = *op;
+    child->ordinal = ordinal;
+    child->terminal = INT_MAX;
+    child->min_format = f;
+    node->children[node->num_children++] = child;
+    return child;
+}
+
+static void any_node_free(AnyNode *node) {
+    for (int k = 0; k < node->num_children; k++) {
+        any_node_free(node->children[k]);
+        free(node->children[k]);
+    }
+    free(node->children);
+}
+
+void my_scanf_set_free(my_scanf_set *set) {
+    if (set == NULL) {
+        return;
+    }
+    any_node_free(&set->root);
+    for (int f = 0; f < set->num_progs; f++) {
+        my_scanf_free(set->progs[f]);
+    }
+    free(set->progs);
+    free(set);
+}
+
+// Returns NULL if a format is NULL or memory runs out
+my_scanf_set *my_scanf_set_compile(const char *formats[], int n) {
+    if (n < 0 || (n > 0 && formats == NULL)) {
+        return NULL;
+    }
+    my_scanf_set *set = calloc(1, sizeof(*set));
+    if (set == NULL) {
+        return NULL;
+    }
+    set->root.terminal = INT_MAX;
+    set->progs = calloc((size_t)(n > 0 ? n : 1), sizeof(*set->progs));
+    if (set->progs == NULL) {
+        free(set);
+        return NULL;
+    }
+
+    for (int f = 0; f < n; f++) {
+        my_scanf_program *prog = my_scanf_compile(formats[f]);
+        if (prog == NULL) {
+            my_scanf_set_free(set);
+            return NULL;
+        }
+        set->progs[set->num_progs++] = prog;
+        // Branches that lose would leak their %mq / %mz strings
+        if (my_scanf_program_allocates(prog)) {
+            my_scanf_set_free(set);
+            return NULL;
+        }
+
+        AnyNode *node = &set->root;
+        int ordinal = 0;
+        for (int k = 0; k < prog->num_ops && node != NULL; k++) {
+            ScanOp op = prog->ops[k];
+            if (op.kind == OP_LITERAL) {
+                for (int b = 0; b < prog->ops[k].literal_len && node != NULL; b++) {
+                    op.literal = prog->ops[k].literal + b;
+                    op.literal_len = 1;
+                    node = any_child(node, &op, ordinal, f);
                 }
+                continue;
+            }
+            node = any_child(node, &op, ordinal, f);
+            if (op.kind == OP_CONVERT && !op.spec.suppress) {
+                ordinal++;
+            }
+        }
+        if (node == NULL) {
+            my_scanf_set_free(set);
+            return NULL;
+        }
+        if (node->terminal > f) {
+            node->terminal = f;
+        }
+        if (ordinal > set->max_dests) {
+            set->max_dests = ordinal;
+        }
+    }
+    return set;
+}
 
-                default:
-                    // Unknown specifier - skip it
-                    break;
+// Stores a value converted for one format into the matching destination of
+// another. Strings are copied up to their NUL, everything else by size.
+static void copy_converted(const ScanOp *op, void *to, const void *from) {
+    switch (op->spec.specifier) {
+        case 's':
+        case 'z':
+        case 'q':
+            strcpy(to, from);
+            break;
+        default:
+            memcpy(to, from, op->dest_size);
+            break;
+    }
+}
+
+typedef struct {
+    InputSource line;      // the buffered line, cur moves as the walk does
+    void ***dests;
+    const AnyNode **path;  // assigning conversions between the root and the walk
+    int depth;
+    int best;              // lowest format that matched so far, or INT_MAX
+} AnyWalk;
+
+static void any_walk(AnyWalk *w, const AnyNode *node) {
+    if (node->terminal < w->best) {
+        w->best = node->terminal;
+        for (int k = 0; k < w->depth; k++) {
+            const AnyNode *conv = w->path[k];
+            void *from = w->dests[conv->min_format][conv->ordinal];
+            void *to = w->dests[w->best][conv->ordinal];
+            if (from != to) {
+                copy_converted(&conv->op, to, from);
             }
+        }
+    }
 
-            continue;
-        } else if (isspace(format[i])) {
-            // Format has whitespace - skip whitespace in input
-            skip_whitespace();
-        } else {
-            // Literal character in format - must match input
-            int c = getchar();
-            if (c != format[i]) {
-                // Mismatch - stop processing
-                if (c != EOF) {
-                    ungetc(c, stdin);
+    const char *start = w->line.cur;
+    int next = (start < w->line.end) ? (unsigned char)*start : EOF;
+    for (int k = 0; k < node->num_children; k++) {
+        const AnyNode *child = node->children[k];
+        // Children are ordered by min_format, so nothing after this can win
+        if (child->min_format >= w->best) {
+            break;
+        }
+        switch (child->op.kind) {
+            case OP_LITERAL:
+                if ((unsigned char)child->op.literal[0] != next) {
+                    continue;
+                }
+                w->line.cur = start + 1;
+                any_walk(w, child);
+                break;
+
+            case OP_WHITESPACE:
+                skip_whitespace(&w->line, 0);
+                any_walk(w, child);
+                break;
+
+            case OP_CONVERT: {
+                void *dest = child->op.spec.suppress ? NULL
+                             : w->dests[child->min_format][child->ordinal];
+                if (child->op.convert(&w->line, &child->op.spec, dest) == 1) {
+                    if (dest != NULL) {
+                        w->path[w->depth++] = child;
+                    }
+                    any_walk(w, child);
+                    if (dest != NULL) {
+                        w->depth--;
+                    }
                 }
-                va_end(args);
-                return assigned_count;
+                break;
             }
         }
+        w->line.cur = start;
+    }
+}
+
+// Refill for the line being walked when it was copied out of an fd, FILE* or
+// reader window: the line is all there is, and unlike mem_refill this tells
+// %v that the bytes will not stay put
+static size_t line_refill(InputSource *src) {
+    (void)src;
+    return 0;
+}
 
-        i++;
+// Buffers the next line of src (without its '\n') and sets *len to its
+// length. Returns a pointer to it in the window, which stays valid until the
+// next refill, or NULL at EOF. Nothing is consumed.
+static const char *source_line(InputSource *src, size_t *len) {
+    // Reader windows start out empty, with no buffer for a mark to point into
+    if (src->cur == src->end && src->refill(src) == 0) {
+        return NULL;
+    }
+    const char *saved_mark = src->mark;
+    if (saved_mark == NULL) {
+        src->mark = src->cur;
+    }
+    size_t start = (size_t)(src->cur - src->mark);
+    size_t scanned = 0;
+    const char *nl;
+    for (;;) {
+        const char *line = src->mark + start;
+        nl = memchr(line + scanned, '\n', (size_t)(src->end - line) - scanned);
+        if (nl != NULL) {
+            break;
+        }
+        scanned = (size_t)(src->end - line);
+        src->cur = src->end;
+        if (src->refill(src) == 0) {
+            break;
+        }
     }
 
-    va_end(args);
-    return assigned_count;
+    const char *line = src->mark + start;
+    src->cur = line;
+    if (saved_mark == NULL) {
+        src->mark = NULL;
+    }
+    *len = (size_t)(((nl != NULL) ? nl : src->end) - line);
+    return line;
+}
+
+static int scan_any(InputSource *src, const my_scanf_set *set, void **dests[]) {
+    size_t len;
+    const char *line = source_line(src, &len);
+    if (line == NULL) {
+        return MY_ANY_EOF;
+    }
+    STAT_INC(src, scans);
+
+    const AnyNode *stack_path[16];
+    AnyWalk w = {
+        .line = { .cur = line, .end = line + len,
+                  .refill = (src->refill == mem_refill) ? mem_refill : line_refill },
+        .dests = dests,
+        .path = stack_path,
+        .best = INT_MAX,
+    };
+#ifdef MY_SCANF_STATS
+    w.line.stats = src->stats;
+#endif
+    if (set->max_dests > 16) {
+        w.path = malloc((size_t)set->max_dests * sizeof(*w.path));
+        if (w.path == NULL) {
+            return MY_ANY_NO_MATCH;
+        }
+    }
+    any_walk(&w, &set->root);
+    if (w.path != stack_path) {
+        free(w.path);
+    }
+
+    // The whole line is consumed, matched or not
+    src->cur = line + len;
+    if (src->cur < src->end) {
+        src->cur++;
+    }
+    STAT_ADD(src, bytes_consumed, src->cur - line);
+    return (w.best == INT_MAX) ? MY_ANY_NO_MATCH : w.best;
+}
+
+int my_scanner_any_exec(my_scanner_t *sc, const my_scanf_set *set, void **dests[]) {
+    int result = scan_any(scanner_enter(sc), set, dests);
+    scanner_leave(sc);
+    return result;
+}
+
+int my_scanf_any_exec(const my_scanf_set *set, void **dests[]) {
+    return my_scanner_any_exec(my_scanner_default(), set, dests);
+}
+
+int my_sscanf_any_exec(const char *str, const my_scanf_set *set, void **dests[]) {
+    InputSource src = { .cur = str, .end = str + strlen(str), .refill = mem_refill };
+    return scan_any(&src, set, dests);
+}
+
+int my_scanner_any(my_scanner_t *sc, const char *formats[], int n, void **dests[]) {
+    my_scanf_set *set = my_scanf_set_compile(formats, n);
+    if (set == NULL) {
+        return MY_ANY_NO_MATCH;
+    }
+    int result = my_scanner_any_exec(sc, set, dests);
+    my_scanf_set_free(set);
+    return result;
+}
+
+int my_scanf_any(const char *formats[], int n, void **dests[]) {
+    return my_scanner_any(my_scanner_default(), formats, n, dests);
+}
+
+int my_sscanf_any(const char *str, const char *formats[], int n, void **dests[]) {
+    my_scanf_set *set = my_scanf_set_compile(formats, n);
+    if (set == NULL) {
+        return MY_ANY_NO_MATCH;
+    }
+    int result = my_sscanf_any_exec(str, set, dests);
+    my_scanf_set_free(set);
+    return result;
+}
+
+// PUSH PARSING
+// A my_scanf_parser turns the engine inside out for non-blocking input: the
+// caller pushes whatever bytes arrived and the parser reports whether a whole
+// record is buffered. The readers themselves stay pull-based. Each attempt
+// runs the program over the buffered bytes from the start of the record, and
+// the refill hook records when a reader wanted to look past them; in that
+// case the record may continue in the next packet, so nothing is consumed and
+// the next feed starts over from the same place. A token split across
+// packets (half of a float, say) therefore just stays in the buffer until the
+// rest of it arrives. Records are short, so re-scanning one is cheaper than
+// saving and restoring every reader's state.
+struct my_scanf_parser {
+    InputSource src;       // first, so parser_refill can get back to the parser
+    my_scanf_program *prog;
+    void **dests;
+    char *data;            // buffered input, [head, tail) not yet consumed
+    size_t head;
+    size_t tail;
+    size_t cap;
+    int starved;           // a reader hit the end of the buffered bytes
+    int resync;            // dropping the rest of a bad line
+    int eof;               // my_parser_finish was called
+};
+
+// Hands the reader an EOF, but remembers that it was only the end of what
+// has arrived so far
+static size_t parser_refill(InputSource *src) {
+    ((my_scanf_parser *)src)->starved = 1;
+    return 0;
+}
+
+my_scanf_parser *my_parser_open(const char *format, void *dests[]) {
+    my_scanf_parser *p = calloc(1, sizeof(*p));
+    if (p == NULL) {
+        return NULL;
+    }
+    p->prog = my_scanf_compile(format);
+    if (p->prog == NULL) {
+        free(p);
+        return NULL;
+    }
+    // A record is re-run until all of it has arrived, which would allocate
+    // a %mq / %mz string on every attempt
+    if (my_scanf_program_allocates(p->prog)) {
+        my_scanf_free(p->prog);
+        free(p);
+        return NULL;
+    }
+    p->dests = dests;
+    p->src.refill = parser_refill;
+    return p;
+}
+
+void my_parser_close(my_scanf_parser *p) {
+    if (p == NULL) {
+        return;
+    }
+    my_scanf_free(p->prog);
+    free(p->data);
+    free(p);
+}
+
+// Appends len bytes after the unconsumed ones, sliding those to the front
+// first when that makes enough room. Returns 0, or -1 if memory runs out.
+static int parser_append(my_scanf_parser *p, const char *bytes, size_t len) {
+    size_t keep = p->tail - p->head;
+    if (p->head > 0 && (keep + len > p->cap - p->tail || p->head >= keep)) {
+        memmove(p->data, p->data + p->head, keep);
+        p->head = 0;
+        p->tail = keep;
+    }
+    if (keep + len > p->cap - p->head) {
+        size_t cap = (p->cap > 0) ? p->cap : 256;
+        while (cap < keep + len) {
+            cap *= 2;
+        }
+        char *data = realloc(p->data, cap);
+        if (data == NULL) {
+            return -1;
+        }
+        p->data = data;
+        p->cap = cap;
+    }
+    memcpy(p->data + p->tail, bytes, len);
+    p->tail += len;
+    return 0;
+}
+
+// Drops buffered bytes up to and including the next newline. Returns 1 once
+// it has been found, 0 if the whole buffer went and the line goes on.
+static int parser_resync(my_scanf_parser *p) {
+    const char *nl = memchr(p->data + p->head, '\n', p->tail - p->head);
+    if (nl == NULL) {
+        p->head = p->tail;
+        return 0;
+    }
+    p->head = (size_t)(nl + 1 - p->data);
+    p->resync = 0;
+    return 1;
+}
+
+// Tries to parse one record out of the buffered bytes
+static int parser_next(my_scanf_parser *p) {
+    if (p->resync && !parser_resync(p)) {
+        return p->eof ? MY_PARSE_END : MY_PARSE_NEED_MORE;
+    }
+
+    const char *start = p->data + p->head;
+    const char *end = p->data + p->tail;
+    if (p->eof) {
+        // Only trailing whitespace left - the stream ended between records
+        const char *q = start;
+        while (q < end && is_space_byte((unsigned char)*q)) {
+            q++;
+        }
+        if (q == end) {
+            p->head = p->tail;
+            return MY_PARSE_END;
+        }
+    } else if (start == end) {
+        return MY_PARSE_NEED_MORE;
+    }
+
+    p->src.cur = start;
+    p->src.end = end;
+    p->starved = 0;
+    DestCursor dests = { .array = p->dests };
+    int completed;
+    run_program(&p->src, p->prog, &dests, &completed);
+
+    if (p->starved && !p->eof) {
+        return MY_PARSE_NEED_MORE;
+    }
+    p->head = (size_t)(p->src.cur - p->data);
+    if (completed) {
+        return MY_PARSE_RECORD;
+    }
+    // Matching failure - skip the rest of the line so the next record starts clean
+    p->resync = 1;
+    parser_resync(p);
+    return MY_PARSE_ERROR;
+}
+
+int my_parser_feed(my_scanf_parser *p, const char *bytes, size_t len) {
+    if (len > 0 && parser_append(p, bytes, len) != 0) {
+        return MY_PARSE_ERROR;
+    }
+    return parser_next(p);
+}
+
+int my_parser_finish(my_scanf_parser *p) {
+    p->eof = 1;
+    return parser_next(p);
+}
+
+// INSTRUMENTATION FRONT ENDS
+// The thread's counters are the ones its default scanner charges
+void my_scanner_stats_get(const my_scanner_t *sc, my_scanf_stats *stats) {
+#ifdef MY_SCANF_STATS
+    *stats = *sc->src.stats;
+#else
+    (void)sc;
+    memset(stats, 0, sizeof(*stats));
+#endif
+}
+
+void my_scanner_stats_reset(my_scanner_t *sc) {
+#ifdef MY_SCANF_STATS
+    memset(sc->src.stats, 0, sizeof(*sc->src.stats));
+#else
+    (void)sc;
+#endif
+}
+
+void my_scanf_stats_get(my_scanf_stats *stats) {
+    my_scanner_stats_get(my_scanner_default(), stats);
+}
+
+void my_scanf_stats_reset(void) {
+    my_scanner_stats_reset(my_scanner_default());
+}
+
+const char *my_scanf_stats_reader_name(int reader) {
+    static const char *const names[MY_SCANF_NUM_READERS] = {
+        "read_integer", "read_long", "read_long_long", "read_short",
+        "read_float", "read_double", "read_long_double", "read_hex_integer",
+        "read_char", "read_string", "read_binary_integer", "read_gen_z",
+        "read_cipher", "read_view"
+    };
+    return (reader >= 0 && reader < MY_SCANF_NUM_READERS) ? names[reader] : NULL;
 }
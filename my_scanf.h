@@ -1,6 +1,319 @@
 #ifndef MY_SCANF_H
 #define MY_SCANF_H
 
+#include <stdarg.h>
+#include <stdio.h>
+#include <stddef.h>
+
+// Result of a %v conversion: a view straight into the input (not copied and
+// not NUL-terminated). %v reads a whitespace-delimited token like %s, %!v the
+// rest of the line with surrounding whitespace trimmed. Views are only
+// produced for input that stays put - my_sscanf strings and my_mmap_open
+// files - and stay valid for as long as that input does. On stdin, FILE*
+// and fd sources %v is a matching failure.
+typedef struct {
+    const char *ptr;
+    size_t len;
+} my_scanf_view;
+
+// %q and %z store into a caller's char array: 256 bytes, or for %z the
+// width, and a longer line is cut short with its rest left unread. With the
+// allocation flag (%mq, %!3mq, %mz, %!mhz - 'm' goes after the width, as in
+// POSIX %ms) the argument is a char ** instead, and the whole line is stored
+// in a malloc'd string the caller frees. A width still caps %mz.
+
+// Reads from stdin (stays in sync with stdio, so it can be mixed with fgets etc.)
 int my_scanf(const char *format, ...);
+int my_vscanf(const char *format, va_list args);
+
+// Reads from an arbitrary FILE*
+int my_fscanf(FILE *stream, const char *format, ...);
+int my_vfscanf(FILE *stream, const char *format, va_list args);
+
+// Reads from a NUL-terminated string in memory
+int my_sscanf(const char *str, const char *format, ...);
+int my_vsscanf(const char *str, const char *format, va_list args);
+
+// Reads from a raw file descriptor with read(2), bypassing stdio. Different
+// descriptors can be scanned from different threads at once; one descriptor
+// is one thread's at a time, as with read(2)
+int my_fdscanf(int fd, const char *format, ...);
+int my_vfdscanf(int fd, const char *format, va_list args);
+// Forgets any input my_fdscanf has buffered for fd; call before closing it
+void my_fdscanf_release(int fd);
+
+// MEMORY-MAPPED FILES
+// my_mmap_open maps a file read-only (with MADV_SEQUENTIAL readahead) and the
+// my_mm* functions scan it straight out of the page cache, continuing from
+// where the previous call stopped. Flags are optional hints:
+//   MY_MMAP_POPULATE - prefault the whole file up front (MAP_POPULATE)
+//   MY_MMAP_HUGEPAGE - ask for transparent huge pages (MADV_HUGEPAGE)
+// Files that cannot be mapped are read into memory instead. Returns NULL if
+// the file cannot be opened or read.
+#define MY_MMAP_POPULATE 0x1
+#define MY_MMAP_HUGEPAGE 0x2
+
+typedef struct my_scanf_mmap my_scanf_mmap;
+
+my_scanf_mmap *my_mmap_open(const char *path, int flags);
+void my_mmap_close(my_scanf_mmap *m);
+int my_mmscanf(my_scanf_mmap *m, const char *format, ...);
+int my_vmmscanf(my_scanf_mmap *m, const char *format, va_list args);
+
+// SCANNER CONTEXTS
+// A my_scanner_t owns one input source and all the state scanning it needs
+// between calls (lookahead buffer, counters). Scanners are independent:
+// give each thread its own and no locks are shared (a FILE* scanner still
+// takes that stream's lock). my_scanf, my_scanf_exec and my_scan_columns run
+// on the calling thread's default scanner, which reads the current stdin.
+//   open_memory/open_string - scans the caller's bytes in place
+//   open_fd   - read(2) into a private buffer (buffer_size 0 = 64 KiB);
+//               the descriptor is not closed by my_scanner_close
+//   open_file - a FILE*, left in sync with stdio after every call
+//   open_path - maps the file like my_mmap_open (flags are MY_MMAP_*)
+//   open_uring - keeps depth io_uring reads of buffer_size bytes in flight
+//               ahead of the parser (0, 0 = 4 reads of 64 KiB); pipes and
+//               sockets get one. Falls back to read(2) without io_uring.
+//               Reads past what was scanned, and the descriptor is not
+//               closed by my_scanner_close
+//   open_pipeline - a reader thread read(2)s ahead into nbuffers buffers of
+//               buffer_size bytes (0, 0 = 4 of 128 KiB) and hands them over
+//               through a lock-free queue; for stdin or pipes where io_uring
+//               is not an option. Reads ahead like open_uring
+// The open functions return NULL on failure.
+typedef struct my_scanner my_scanner_t;
+
+my_scanner_t *my_scanner_default(void);
+my_scanner_t *my_scanner_open_memory(const char *buf, size_t len);
+my_scanner_t *my_scanner_open_string(const char *str);
+my_scanner_t *my_scanner_open_fd(int fd, size_t buffer_size);
+my_scanner_t *my_scanner_open_file(FILE *stream);
+my_scanner_t *my_scanner_open_path(const char *path, int mmap_flags);
+my_scanner_t *my_scanner_open_uring(int fd, int depth, size_t buffer_size);
+my_scanner_t *my_scanner_open_pipeline(int fd, int nbuffers, size_t buffer_size);
+void my_scanner_close(my_scanner_t *sc);
+
+int my_scanner_scanf(my_scanner_t *sc, const char *format, ...);
+int my_scanner_vscanf(my_scanner_t *sc, const char *format, va_list args);
+
+// Transactional scanning: my_scanner_checkpoint remembers the current input
+// position, my_scanner_rollback returns to it (as often as needed, however
+// much was read since) and my_scanner_commit forgets it. Only one checkpoint
+// is open at a time; taking a new one replaces it. While one is open the
+// scanner buffers everything read since, so commit once a record is done.
+// A FILE* scanner is out of sync with stdio until the commit.
+void my_scanner_checkpoint(my_scanner_t *sc);
+void my_scanner_rollback(my_scanner_t *sc);
+void my_scanner_commit(my_scanner_t *sc);
+
+// PUSH PARSING
+// For input that arrives in pieces (non-blocking sockets, pipes in an event
+// loop). my_parser_open compiles format once; dests holds one pointer per
+// assigned conversion, as for my_scanf_exec. Each my_parser_feed appends
+// bytes to the parser's buffer and tries to parse the next record into dests:
+//   MY_PARSE_RECORD    - dests hold a complete record; feed (p, NULL, 0)
+//                        again for any further records already buffered
+//   MY_PARSE_NEED_MORE - the buffered bytes end inside a record (or there
+//                        are none); nothing is consumed until more arrive
+//   MY_PARSE_ERROR     - the record did not match; the rest of its line is
+//                        skipped and parsing resumes on the next line
+// A record ends where its last conversion stops, so leave trailing
+// whitespace out of the format or every record waits for the next one.
+// my_parser_finish marks the end of input, returns any final record and then
+// MY_PARSE_END. %v is not available (the buffer moves between feeds), and
+// my_parser_open refuses %mq / %mz (an incomplete record is run again).
+#define MY_PARSE_ERROR     -1
+#define MY_PARSE_NEED_MORE  0
+#define MY_PARSE_RECORD     1
+#define MY_PARSE_END        2
+
+typedef struct my_scanf_parser my_scanf_parser;
+
+my_scanf_parser *my_parser_open(const char *format, void *dests[]);
+int my_parser_feed(my_scanf_parser *p, const char *bytes, size_t len);
+int my_parser_finish(my_scanf_parser *p);
+void my_parser_close(my_scanf_parser *p);
+
+// MULTIPLEXED STREAMS
+// A my_scanf_mux parses many descriptors (pipes, sockets, FIFOs, regular
+// files) from one thread: each is registered with its own format and
+// destinations, made non-blocking, and watched with epoll. my_mux_run waits
+// up to timeout_ms (-1 = forever) for input, reads what arrived and calls
+// callback(user, fd, status) for every record: MY_PARSE_RECORD when dests
+// hold one, MY_PARSE_ERROR when a line did not match. At EOF the stream gets
+// a final MY_PARSE_END and is removed (the descriptor is not closed).
+// my_mux_run returns the number of streams still registered, or -1 if
+// epoll fails. Callbacks may add and remove streams. One mux per thread.
+typedef struct my_scanf_mux my_scanf_mux;
+typedef void (*my_mux_callback)(void *user, int fd, int status);
+
+my_scanf_mux *my_mux_new(void);
+void my_mux_free(my_scanf_mux *mx);
+int my_mux_add(my_scanf_mux *mx, int fd, const char *format, void *dests[],
+               my_mux_callback callback, void *user);
+int my_mux_remove(my_scanf_mux *mx, int fd);
+int my_mux_count(const my_scanf_mux *mx);
+int my_mux_run(my_scanf_mux *mx, int timeout_ms);
+
+// COMPILED FORMATS
+// my_scanf_compile parses a format string once into an immutable program
+// (literal runs, whitespace skips and conversions with their reader already
+// chosen). The *_exec functions run it like the matching scanf front end,
+// with no format parsing at runtime. A program may be shared between threads.
+typedef struct my_scanf_program my_scanf_program;
+
+my_scanf_program *my_scanf_compile(const char *format);
+void my_scanf_free(my_scanf_program *prog);
+
+int my_scanf_exec(const my_scanf_program *prog, ...);
+int my_vscanf_exec(const my_scanf_program *prog, va_list args);
+int my_fscanf_exec(FILE *stream, const my_scanf_program *prog, ...);
+int my_vfscanf_exec(FILE *stream, const my_scanf_program *prog, va_list args);
+int my_sscanf_exec(const char *str, const my_scanf_program *prog, ...);
+int my_vsscanf_exec(const char *str, const my_scanf_program *prog, va_list args);
+int my_fdscanf_exec(int fd, const my_scanf_program *prog, ...);
+int my_vfdscanf_exec(int fd, const my_scanf_program *prog, va_list args);
+int my_mmscanf_exec(my_scanf_mmap *m, const my_scanf_program *prog, ...);
+int my_vmmscanf_exec(my_scanf_mmap *m, const my_scanf_program *prog, va_list args);
+int my_scanner_exec(my_scanner_t *sc, const my_scanf_program *prog, ...);
+int my_scanner_vexec(my_scanner_t *sc, const my_scanf_program *prog, va_list args);
+
+// BULK COLUMN SCANNING
+// Applies format to up to n consecutive records and stores the fields in
+// struct-of-arrays form: the k-th assigned conversion of record i goes to
+// element i of the array cols[k] (int[], double[], char[][W], ...). For
+// %s the row size is width + 1, for %c and %z it is the width, and without
+// a width character rows are 256 bytes; %mq and %mz rows are char *, each
+// the caller's to free. Returns the number of records that matched
+// completely; scanning stops at the first record that does not.
+int my_scan_columns(const char *format, int n, void *cols[]);
+int my_fscan_columns(FILE *stream, const char *format, int n, void *cols[]);
+int my_sscan_columns(const char *str, const char *format, int n, void *cols[]);
+int my_fdscan_columns(int fd, const char *format, int n, void *cols[]);
+int my_mmscan_columns(my_scanf_mmap *m, const char *format, int n, void *cols[]);
+int my_scanner_scan_columns(my_scanner_t *sc, const char *format, int n, void *cols[]);
+
+// MULTI-FORMAT MATCHING
+// For input whose lines come in many shapes (log messages, mixed records).
+// my_scanf_set_compile merges a list of formats into one prefix trie, so
+// literal text and conversions that formats start with are matched once per
+// line rather than once per format. Each *_any call reads one line, finds
+// the first format in list order that matches it completely and returns its
+// index; its conversions are stored through dests[index], an array with one
+// pointer per non-suppressed conversion (as for my_parser_open). The line is
+// consumed whether or not anything matched. MY_ANY_NO_MATCH means no format
+// matched and MY_ANY_EOF that there was no line left. Destinations of formats
+// that did not win may still have been written to. A set may be shared
+// between threads. %v only works on memory and mapped scanners, and formats
+// with %mq / %mz are refused (the losing branches' strings would leak).
+#define MY_ANY_EOF      -1
+#define MY_ANY_NO_MATCH -2
+
+typedef struct my_scanf_set my_scanf_set;
+
+my_scanf_set *my_scanf_set_compile(const char *formats[], int n);
+void my_scanf_set_free(my_scanf_set *set);
+
+int my_scanf_any(const char *formats[], int n, void **dests[]);
+int my_sscanf_any(const char *str, const char *formats[], int n, void **dests[]);
+int my_scanner_any(my_scanner_t *sc, const char *formats[], int n, void **dests[]);
+int my_scanf_any_exec(const my_scanf_set *set, void **dests[]);
+int my_sscanf_any_exec(const char *str, const my_scanf_set *set, void **dests[]);
+int my_scanner_any_exec(my_scanner_t *sc, const my_scanf_set *set, void **dests[]);
+
+// PARALLEL FILE SCANNING
+// my_scan_columns for a regular file whose records are one per line, spread
+// over nthreads worker threads (0 = one per online CPU). The file is mapped,
+// split at newline boundaries, and each chunk is scanned in parallel straight
+// into its place in cols, so the result matches a sequential
+// my_scan_columns over the same file (rows past the returned count may be
+// overwritten, though). Returns the number of records stored (at most n), or
+// -1 if the file cannot be read or the format
+// allocates (%mq, %mz) or stores views (%v; the mapping is gone by the time
+// this returns - use my_mmap_open with my_mmscan_columns instead).
+long my_scan_columns_parallel(const char *path, const char *format, long n,
+                              void *cols[], int nthreads);
+
+// TEXT STREAMS
+// Applies the %q transform (%Nq, or %!Nq with invert_case) to everything
+// read from in_fd until EOF and writes the result to out_fd, newlines and
+// all, in buffers of 1 MiB. There is no line length limit. Returns the
+// number of bytes written, or -1 on a read or write error.
+long long my_cipher_stream(int in_fd, int out_fd, int offset, int invert_case);
+
+// The same for %z: every line read from in_fd is written to out_fd the way
+// %z would return it (leading and trailing whitespace trimmed, the suffix
+// appended; an empty or all-whitespace line becomes the bare suffix),
+// followed by its newline. Line bytes go straight from the read buffer to
+// writev(2), and there is no line length limit. Returns the number of bytes
+// written, or -1 on an error or an unknown mode.
+typedef enum {
+    MY_GENZ_LOL,             // %z   → " lol"
+    MY_GENZ_LOL_EXCLAIM,     // %!z  → " lol!"
+    MY_GENZ_HAHA             // %!hz → " haha!"
+} my_genz_mode;
+
+long long my_genz_stream(int in_fd, int out_fd, my_genz_mode mode);
+
+// SIMD KERNELS
+// The whitespace, decimal, hex and binary scanning loops and the %q shift
+// exist in avx512bw, avx2, sse4.2, sse2 and scalar builds; the best one this
+// CPU supports is chosen when the library loads (the MY_SCANF_KERNELS
+// environment variable can name another). my_scanf_kernels returns the name
+// of the set in use, and my_scanf_use_kernels switches sets by name (NULL =
+// best available), returning -1 if this CPU cannot run it. Switch only while
+// no other thread is scanning.
+const char *my_scanf_kernels(void);
+int my_scanf_use_kernels(const char *name);
+
+// INSTRUMENTATION
+// Build the library with -DMY_SCANF_STATS to count what the scanner spends
+// its time on. Every scanner opened with my_scanner_open_* keeps its own
+// counters; everything else (my_scanf, my_sscanf, my_fdscanf, ...) charges
+// the calling thread's counters, which my_scanf_stats_get copies and
+// my_scanf_stats_reset clears. Without the macro nothing is counted (the
+// hooks compile away) and the getters report all zeros.
+enum {
+    MY_SCANF_READ_INTEGER,       // %d
+    MY_SCANF_READ_LONG,          // %ld
+    MY_SCANF_READ_LONG_LONG,     // %lld
+    MY_SCANF_READ_SHORT,         // %hd
+    MY_SCANF_READ_FLOAT,         // %f
+    MY_SCANF_READ_DOUBLE,        // %lf
+    MY_SCANF_READ_LONG_DOUBLE,   // %Lf
+    MY_SCANF_READ_HEX,           // %x
+    MY_SCANF_READ_CHAR,          // %c
+    MY_SCANF_READ_STRING,        // %s
+    MY_SCANF_READ_BINARY,        // %b
+    MY_SCANF_READ_GEN_Z,         // %z
+    MY_SCANF_READ_CIPHER,        // %q
+    MY_SCANF_READ_VIEW,          // %v
+    MY_SCANF_NUM_READERS
+};
+
+typedef struct {
+    unsigned long long calls;              // conversions attempted
+    unsigned long long matching_failures;  // input did not fit the conversion
+    unsigned long long input_failures;     // EOF (or unusable source) first
+    unsigned long long cycles;             // time inside the reader (TSC ticks)
+} my_scanf_reader_stats;
+
+typedef struct {
+    unsigned long long scans;               // format runs (calls, or records for columns)
+    unsigned long long bytes_consumed;      // input bytes taken off the sources
+    unsigned long long whitespace_skipped;  // of those, leading/format whitespace
+    unsigned long long pushbacks;           // bytes put back after a lookahead
+    unsigned long long refills;             // window refills (reads for fd sources)
+    unsigned long long literal_mismatches;  // scans stopped by a format literal
+    unsigned long long float_slow_paths;    // floats converted through strto*()
+    my_scanf_reader_stats readers[MY_SCANF_NUM_READERS];
+} my_scanf_stats;
+
+void my_scanf_stats_get(my_scanf_stats *stats);
+void my_scanf_stats_reset(void);
+// "read_integer", "read_float", ... for MY_SCANF_READ_* (NULL if out of range)
+const char *my_scanf_stats_reader_name(int reader);
+void my_scanner_stats_get(const my_scanner_t *sc, my_scanf_stats *stats);
+void my_scanner_stats_reset(my_scanner_t *sc);
 
-#endif
\ No newline at end of file
+#endif
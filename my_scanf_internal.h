@@ -0,0 +1,71 @@
+#ifndef MY_SCANF_INTERNAL_H
+#define MY_SCANF_INTERNAL_H
+
+// Pieces of the scanning engine shared between the library's own source
+// files. Nothing here is part of the public API in my_scanf.h.
+
+#include <stddef.h>
+#include <stdint.h>
+#include "my_scanf.h"
+
+// Number of pointers a program consumes (its non-suppressed conversions)
+int my_scanf_program_num_dests(const my_scanf_program *prog);
+
+// Bytes stored through the k-th destination, i.e. its column row size
+size_t my_scanf_program_dest_size(const my_scanf_program *prog, int k);
+
+// Whether any conversion stores a %v view, which points into the input and
+// so dies with it
+int my_scanf_program_has_views(const my_scanf_program *prog);
+
+// Whether any conversion stores a malloc'd string (%mq, %mz). Those cannot
+// be run speculatively: a retried or discarded record would leak it.
+int my_scanf_program_allocates(const my_scanf_program *prog);
+
+// my_scan_columns over the bytes [buf, buf + len), which need not be
+// NUL-terminated. *consumed is set to the number of bytes scanned.
+int my_scan_columns_range(const char *buf, size_t len, const my_scanf_program *prog,
+                          int n, void *cols[], size_t *consumed);
+
+// The whole contents of a my_mmap_open handle (mapped or read into memory)
+const char *my_mmap_data(const my_scanf_mmap *m, size_t *len);
+
+// Buffer readers hand a scanner its input one whole buffer at a time, in
+// order, from machinery running ahead of the parser (io_uring reads in
+// flight, a reader thread). next returns the length of the next buffer, or
+// 0 at EOF or on error. After an error, next sets errno as read(2) would,
+// on that call and every later one. The buffer stays valid until the
+// following call and has MY_READER_HEADROOM writable bytes in front of it,
+// so a caller can prepend a short unread tail. Neither closes the
+// descriptor.
+#define MY_READER_HEADROOM 64
+
+typedef struct my_buffer_reader my_buffer_reader;
+
+struct my_buffer_reader {
+    size_t (*next)(my_buffer_reader *r, char **data);
+    void (*close)(my_buffer_reader *r);
+};
+
+// io_uring read-ahead (my_scanf_uring.c), read(2) where io_uring is unavailable
+my_buffer_reader *my_uring_reader_open(int fd, int depth, size_t buffer_size);
+
+// Reader thread feeding a queue of buffers (my_scanf_pipeline.c)
+my_buffer_reader *my_thread_reader_open(int fd, int nbuffers, size_t buffer_size);
+
+// SIMD kernels picked at load time for this CPU (see my_scanf_kernels.c).
+// Each returns the length of the matching run at the start of [p, p + len).
+// fold_binary_digits also appends the run's bits to *acc (modulo 2^64).
+// translate_cipher applies the %q shift (offset 0-25) to all len bytes.
+typedef struct {
+    const char *name;
+    size_t (*span_whitespace)(const char *p, size_t len, int keep_newline);
+    size_t (*span_digits)(const char *p, size_t len);
+    size_t (*span_hex_digits)(const char *p, size_t len);
+    size_t (*fold_binary_digits)(const char *p, size_t len, uint64_t *acc);
+    void (*translate_cipher)(char *out, const char *in, size_t len, int offset, int invert_case);
+} my_scanf_kernel_set;
+
+extern my_scanf_kernel_set my_scanf_active_kernels;
+
+#endif
@@ -0,0 +1,550 @@
+#include "my_scanf.h"
+#include "my_scanf_internal.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define SCAN_KERNELS_X86 1
+#endif
+
+
+// SIMD SCANNING KERNELS
+// The readers spend their time classifying runs of bytes: whitespace before
+// every conversion, decimal digits for %d, hex digits for %x, and '0'/'1'
+// for %b, which is folded in the same pass (the compare mask of the '1'
+// bytes already is the value, bit-reversed). The %q Caesar shift is a
+// byte-for-byte transform of the same kind. Each of those loops comes in
+// several builds and the best one this CPU can run is bound
+// once, at load time, into my_scanf_active_kernels:
+//   avx512bw - 64 bytes per compare, and masked loads for the tail
+//   avx2     - 32 bytes per compare
+//   sse4.2   - PCMPESTRI set/range matching, 16 bytes per step
+//   sse2     - 16 bytes per compare (every x86-64 CPU has it)
+//   scalar   - portable fallback, SWAR for digits on little-endian targets
+// The wider builds are compiled with target attributes, so one binary
+// carries all of them regardless of -march. Every kernel returns the length
+// of the matching run at the start of [p, p + len) and never reads past
+// p + len.
+
+// Shared by the %b folds: acc keeps the low 64 bits of the binary number
+// read so far. k new bits (1-64) are appended with the first byte on top.
+static inline uint64_t shift_in_bits(uint64_t acc, uint64_t bits, size_t k) {
+    return (k >= 64) ? bits : (acc << k) | bits;
+}
+
+static inline uint64_t reverse_bits64(uint64_t x) {
+    x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+    x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+    x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return __builtin_bswap64(x);
+}
+
+// Value of the first k (1-64) bytes of a block, given the mask of its '1'
+// bytes (bit i set for byte i)
+static inline uint64_t mask_to_bits(uint64_t ones, size_t k) {
+    return reverse_bits64(ones) >> (64 - k);
+}
+
+// Scalar kernels
+static inline int is_space_byte(unsigned char c) {
+    return c == ' ' || (unsigned char)(c - '\t') <= '\r' - '\t';
+}
+
+static inline int is_hex_byte(unsigned char c) {
+    return (unsigned char)(c - '0') < 10 || (unsigned char)((c | 0x20) - 'a') < 6;
+}
+
+static size_t span_whitespace_scalar(const char *p, size_t len, int keep_newline) {
+    size_t n = 0;
+    while (n < len && is_space_byte((unsigned char)p[n]) && !(keep_newline && p[n] == '\n')) {
+        n++;
+    }
+    return n;
+}
+
+static size_t span_digits_scalar(const char *p, size_t len) {
+    size_t n = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // Eight bytes at a time: a byte is a digit iff it is 0x30-0x39
+    while (len - n >= 8) {
+        uint64_t word;
+        memcpy(&word, p + n, sizeof(word));
+        uint64_t t = word ^ 0x3030303030303030ULL;
+        uint64_t bad = (t & 0xF0F0F0F0F0F0F0F0ULL) |
+                       (((t & 0x0F0F0F0F0F0F0F0FULL) + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL);
+        if (bad != 0) {
+            return n + (size_t)__builtin_ctzll(bad) / 8;
+        }
+        n += 8;
+    }
+#endif
+    while (n < len && (unsigned char)(p[n] - '0') < 10) {
+        n++;
+    }
+    return n;
+}
+
+static size_t span_hex_digits_scalar(const char *p, size_t len) {
+    size_t n = 0;
+    while (n < len && is_hex_byte((unsigned char)p[n])) {
+        n++;
+    }
+    return n;
+}
+
+static size_t fold_binary_digits_scalar(const char *p, size_t len, uint64_t *acc) {
+    size_t n = 0;
+    uint64_t value = *acc;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // Eight bytes at a time: '0'/'1' xor '0' leaves 0/1 in each byte, and one
+    // multiply gathers those bits into the top byte, first byte highest
+    while (len - n >= 8) {
+        uint64_t word;
+        memcpy(&word, p + n, sizeof(word));
+        uint64_t t = word ^ 0x3030303030303030ULL;
+        uint64_t bad = t & 0xFEFEFEFEFEFEFEFEULL;
+        size_t k = (bad != 0) ? (size_t)__builtin_ctzll(bad) / 8 : 8;
+        if (k > 0) {
+            uint64_t bits = ((t & 0x0101010101010101ULL) * 0x8040201008040201ULL) >> 56;
+            value = shift_in_bits(value, bits >> (8 - k), k);
+        }
+        n += k;
+        if (k < 8) {
+            *acc = value;
+            return n;
+        }
+    }
+#endif
+    while (n < len && (p[n] == '0' || p[n] == '1')) {
+        value = (value << 1) | (uint64_t)(p[n] - '0');
+        n++;
+    }
+    *acc = value;
+    return n;
+}
+
+// %q translation tables, one per (invert_case, offset) pair, so the scalar
+// path is a single lookup per byte. Built when the library loads.
+static unsigned char cipher_tables[2][26][256];
+
+__attribute__((constructor))
+static void build_cipher_tables(void) {
+    for (int invert = 0; invert < 2; invert++) {
+        for (int offset = 0; offset < 26; offset++) {
+            unsigned char *table = cipher_tables[invert][offset];
+            for (int c = 0; c < 256; c++) {
+                table[c] = (unsigned char)c;
+            }
+            for (int k = 0; k < 26; k++) {
+                int shifted = (k + offset) % 26;
+                table['a' + k] = (unsigned char)((invert ? 'A' : 'a') + shifted);
+                table['A' + k] = (unsigned char)((invert ? 'a' : 'A') + shifted);
+            }
+        }
+    }
+}
+
+// offset is already reduced to 0-25. out may be in.
+static void translate_cipher_scalar(char *out, const char *in, size_t len, int offset, int invert_case) {
+    const unsigned char *table = cipher_tables[invert_case != 0][offset];
+    for (size_t k = 0; k < len; k++) {
+        out[k] = (char)table[(unsigned char)in[k]];
+    }
+}
+
+#ifdef SCAN_KERNELS_X86
+// SSE2 kernels. Byte classes come from unsigned range checks:
+// x - lo <= hi - lo  <=>  min(x - lo, hi - lo) == x - lo
+static inline __m128i sse2_in_range(__m128i v, char lo, char hi) {
+    __m128i d = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+    return _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8((char)(hi - lo))), d);
+}
+
+static size_t span_whitespace_sse2(const char *p, size_t len, int keep_newline) {
+    size_t n = 0;
+    while (len - n >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + n));
+        __m128i ws = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), sse2_in_range(v, '\t', '\r'));
+        if (keep_newline) {
+            ws = _mm_andnot_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), ws);
+        }
+        unsigned mask = (unsigned)_mm_movemask_epi8(ws);
+        if (mask != 0xFFFFu) {
+            return n + (size_t)__builtin_ctz(~mask);
+        }
+        n += 16;
+    }
+    return n + span_whitespace_scalar(p + n, len - n, keep_newline);
+}
+
+static size_t span_digits_sse2(const char *p, size_t len) {
+    size_t n = 0;
+    while (len - n >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + n));
+        unsigned mask = (unsigned)_mm_movemask_epi8(sse2_in_range(v, '0', '9'));
+        if (mask != 0xFFFFu) {
+            return n + (size_t)__builtin_ctz(~mask);
+        }
+        n += 16;
+    }
+    return n + span_digits_scalar(p + n, len - n);
+}
+
+static size_t span_hex_digits_sse2(const char *p, size_t len) {
+    size_t n = 0;
+    while (len - n >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + n));
+        __m128i hex = _mm_or_si128(sse2_in_range(v, '0', '9'),
+                                   sse2_in_range(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'f'));
+        unsigned mask = (unsigned)_mm_movemask_epi8(hex);
+        if (mask != 0xFFFFu) {
+            return n + (size_t)__builtin_ctz(~mask);
+        }
+        n += 16;
+    }
+    return n + span_hex_digits_scalar(p + n, len - n);
+}
+
+// PMOVMSKB of the '1' compare is the block's bits in reverse order
+static size_t fold_binary_digits_sse2(const char *p, size_t len, uint64_t *acc) {
+    size_t n = 0;
+    uint64_t value = *acc;
+    while (len - n >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + n));
+        __m128i ones = _mm_cmpeq_epi8(v, _mm_set1_epi8('1'));
+        unsigned one_mask = (unsigned)_mm_movemask_epi8(ones);
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_or_si128(ones, _mm_cmpeq_epi8(v, _mm_set1_epi8('0'))));
+        size_t k = (mask != 0xFFFFu) ? (size_t)__builtin_ctz(~mask) : 16;
+        if (k > 0) {
+            value = shift_in_bits(value, mask_to_bits(one_mask, k), k);
+        }
+        n += k;
+        if (k < 16) {
+            *acc = value;
+            return n;
+        }
+    }
+    *acc = value;
+    return n + fold_binary_digits_scalar(p + n, len - n, acc);
+}
+
+// The table lookup as byte arithmetic: fold letters to lowercase, add the
+// offset, subtract 26 from anything past 'z', then put the original case
+// back (flipped for %!q). Non-letters are blended through untouched.
+static void translate_cipher_sse2(char *out, const char *in, size_t len, int offset, int invert_case) {
+    const __m128i shift = _mm_set1_epi8((char)offset);
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    const __m128i flip = _mm_set1_epi8(invert_case ? 0x20 : 0);
+    size_t n = 0;
+    for (; len - n >= 16; n += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(in + n));
+        __m128i lower = _mm_or_si128(v, case_bit);
+        __m128i letter = sse2_in_range(lower, 'a', 'z');
+        __m128i r = _mm_add_epi8(lower, shift);
+        __m128i wrap = _mm_cmpeq_epi8(_mm_max_epu8(r, _mm_set1_epi8('z' + 1)), r);
+        r = _mm_sub_epi8(r, _mm_and_si128(wrap, _mm_set1_epi8(26)));
+        r = _mm_xor_si128(_mm_andnot_si128(case_bit, r), _mm_xor_si128(_mm_and_si128(v, case_bit), flip));
+        _mm_storeu_si128((__m128i *)(out + n), _mm_or_si128(_mm_and_si128(letter, r), _mm_andnot_si128(letter, v)));
+    }
+    translate_cipher_scalar(out + n, in + n, len - n, offset, invert_case);
+}
+
+// SSE4.2 kernels: PCMPESTRI with negative polarity returns the index of the
+// first byte outside the set (or range list), 16 if there is none. Explicit
+// lengths keep NUL bytes in the input from ending the match early.
+#define SSE42_FIRST_MISS (_SIDD_UBYTE_OPS | _SIDD_NEGATIVE_POLARITY | _SIDD_LEAST_SIGNIFICANT)
+
+__attribute__((target("sse4.2")))
+static size_t span_whitespace_sse42(const char *p, size_t len, int keep_newline) {
+    // '\n' last, so keep_newline just shortens the set by one
+    const __m128i set = _mm_setr_epi8(' ', '\t', '\v', '\f', '\r', '\n', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    int set_len = keep_newline ? 5 : 6;
+    size_t n = 0;
+    while (len - n >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + n));
+        int i = _mm_cmpestri(set, set_len, v, 16, SSE42_FIRST_MISS | _SIDD_CMP_EQUAL_ANY);
+        if (i < 16) {
+            return n + (size_t)i;
+        }
+        n += 16;
+    }
+    return n + span_whitespace_scalar(p + n, len - n, keep_newline);
+}
+
+__attribute__((target("sse4.2")))
+static size_t span_hex_digits_sse42(const char *p, size_t len) {
+    const __m128i ranges = _mm_setr_epi8('0', '9', 'a', 'f', 'A', 'F', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    size_t n = 0;
+    while (len - n >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + n));
+        int i = _mm_cmpestri(ranges, 6, v, 16, SSE42_FIRST_MISS | _SIDD_CMP_RANGES);
+        if (i < 16) {
+            return n + (size_t)i;
+        }
+        n += 16;
+    }
+    return n + span_hex_digits_scalar(p + n, len - n);
+}
+
+// AVX2 kernels: the SSE2 classifications on 32 bytes, then SSE2 for the tail
+__attribute__((target("avx2")))
+static inline __m256i avx2_in_range(__m256i v, char lo, char hi) {
+    __m256i d = _mm256_sub_epi8(v, _mm256_set1_epi8(lo));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8((char)(hi - lo))), d);
+}
+
+__attribute__((target("avx2")))
+static size_t span_whitespace_avx2(const char *p, size_t len, int keep_newline) {
+    size_t n = 0;
+    while (len - n >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + n));
+        __m256i ws = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                                     avx2_in_range(v, '\t', '\r'));
+        if (keep_newline) {
+            ws = _mm256_andnot_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), ws);
+        }
+        unsigned mask = (unsigned)_mm256_movemask_epi8(ws);
+        if (mask != 0xFFFFFFFFu) {
+            return n + (size_t)__builtin_ctz(~mask);
+        }
+        n += 32;
+    }
+    return n + span_whitespace_sse2(p + n, len - n, keep_newline);
+}
+
+__attribute__((target("avx2")))
+static size_t span_digits_avx2(const char *p, size_t len) {
+    size_t n = 0;
+    while (len - n >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + n));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(avx2_in_range(v, '0', '9'));
+        if (mask != 0xFFFFFFFFu) {
+            return n + (size_t)__builtin_ctz(~mask);
+        }
+        n += 32;
+    }
+    return n + span_digits_sse2(p + n, len - n);
+}
+
+__attribute__((target("avx2")))
+static size_t span_hex_digits_avx2(const char *p, size_t len) {
+    size_t n = 0;
+    while (len - n >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + n));
+        __m256i hex = _mm256_or_si256(avx2_in_range(v, '0', '9'),
+                                      avx2_in_range(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'f'));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(hex);
+        if (mask != 0xFFFFFFFFu) {
+            return n + (size_t)__builtin_ctz(~mask);
+        }
+        n += 32;
+    }
+    return n + span_hex_digits_sse2(p + n, len - n);
+}
+
+__attribute__((target("avx2")))
+static size_t fold_binary_digits_avx2(const char *p, size_t len, uint64_t *acc) {
+    size_t n = 0;
+    uint64_t value = *acc;
+    while (len - n >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + n));
+        __m256i ones = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('1'));
+        unsigned one_mask = (unsigned)_mm256_movemask_epi8(ones);
+        unsigned mask = (unsigned)_mm256_movemask_epi8(
+            _mm256_or_si256(ones, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('0'))));
+        size_t k = (mask != 0xFFFFFFFFu) ? (size_t)__builtin_ctz(~mask) : 32;
+        if (k > 0) {
+            value = shift_in_bits(value, mask_to_bits(one_mask, k), k);
+        }
+        n += k;
+        if (k < 32) {
+            *acc = value;
+            return n;
+        }
+    }
+    *acc = value;
+    return n + fold_binary_digits_sse2(p + n, len - n, acc);
+}
+
+__attribute__((target("avx2")))
+static void translate_cipher_avx2(char *out, const char *in, size_t len, int offset, int invert_case) {
+    const __m256i shift = _mm256_set1_epi8((char)offset);
+    const __m256i case_bit = _mm256_set1_epi8(0x20);
+    const __m256i flip = _mm256_set1_epi8(invert_case ? 0x20 : 0);
+    size_t n = 0;
+    for (; len - n >= 32; n += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(in + n));
+        __m256i lower = _mm256_or_si256(v, case_bit);
+        __m256i letter = avx2_in_range(lower, 'a', 'z');
+        __m256i r = _mm256_add_epi8(lower, shift);
+        __m256i wrap = _mm256_cmpeq_epi8(_mm256_max_epu8(r, _mm256_set1_epi8('z' + 1)), r);
+        r = _mm256_sub_epi8(r, _mm256_and_si256(wrap, _mm256_set1_epi8(26)));
+        r = _mm256_xor_si256(_mm256_andnot_si256(case_bit, r),
+                             _mm256_xor_si256(_mm256_and_si256(v, case_bit), flip));
+        _mm256_storeu_si256((__m256i *)(out + n), _mm256_blendv_epi8(v, r, letter));
+    }
+    translate_cipher_sse2(out + n, in + n, len - n, offset, invert_case);
+}
+
+// AVX-512 kernels: compares produce a 64-bit mask directly, and the tail is
+// a masked load (bytes past p + len are never touched, so it cannot fault)
+#define AVX512_TARGET __attribute__((target("avx512f,avx512bw")))
+
+AVX512_TARGET
+static inline __m512i avx512_load(const char *p, size_t avail, uint64_t *valid) {
+    if (avail >= 64) {
+        *valid = ~0ULL;
+        return _mm512_loadu_si512((const void *)p);
+    }
+    *valid = (1ULL << avail) - 1;
+    return _mm512_maskz_loadu_epi8(*valid, p);
+}
+
+AVX512_TARGET
+static inline __mmask64 avx512_in_range(__m512i v, char lo, char hi) {
+    return _mm512_cmple_epu8_mask(_mm512_sub_epi8(v, _mm512_set1_epi8(lo)),
+                                  _mm512_set1_epi8((char)(hi - lo)));
+}
+
+// Shared loop: class(v) is the mask of matching bytes in a 64-byte block
+#define AVX512_SPAN(p, len, class_mask)                                  \
+    do {                                                                 \
+        size_t n_ = 0;                                                   \
+        while (n_ < (len)) {                                             \
+            uint64_t valid_;                                             \
+            __m512i v = avx512_load((p) + n_, (len) - n_, &valid_);      \
+            uint64_t miss_ = ~(uint64_t)(class_mask) & valid_;           \
+            if (miss_ != 0) {                                            \
+                return n_ + (size_t)__builtin_ctzll(miss_);              \
+            }                                                            \
+            n_ += 64;                                                    \
+        }                                                                \
+        return (len);                                                    \
+    } while (0)
+
+AVX512_TARGET
+static size_t span_whitespace_avx512(const char *p, size_t len, int keep_newline) {
+    uint64_t newline_ok = keep_newline ? 0 : ~0ULL;
+    AVX512_SPAN(p, len,
+                (_mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(' ')) | avx512_in_range(v, '\t', '\r')) &
+                (~_mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\n')) | newline_ok));
+}
+
+AVX512_TARGET
+static size_t span_digits_avx512(const char *p, size_t len) {
+    AVX512_SPAN(p, len, avx512_in_range(v, '0', '9'));
+}
+
+AVX512_TARGET
+static size_t span_hex_digits_avx512(const char *p, size_t len) {
+    AVX512_SPAN(p, len,
+                avx512_in_range(v, '0', '9') |
+                avx512_in_range(_mm512_or_si512(v, _mm512_set1_epi8(0x20)), 'a', 'f'));
+}
+
+// A whole 64-bit field in one block: the '1' mask reversed is the value
+AVX512_TARGET
+static size_t fold_binary_digits_avx512(const char *p, size_t len, uint64_t *acc) {
+    size_t n = 0;
+    uint64_t value = *acc;
+    while (n < len) {
+        uint64_t valid;
+        __m512i v = avx512_load(p + n, len - n, &valid);
+        uint64_t ones = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('1'));
+        uint64_t miss = ~(ones | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('0'))) & valid;
+        size_t k = (miss != 0) ? (size_t)__builtin_ctzll(miss) : (len - n < 64 ? len - n : 64);
+        if (k > 0) {
+            value = shift_in_bits(value, mask_to_bits(ones, k), k);
+        }
+        n += k;
+        if (miss != 0) {
+            break;
+        }
+    }
+    *acc = value;
+    return n;
+}
+#endif
+
+// RUNTIME DISPATCH
+// Kernel sets from widest to narrowest. The first one the CPU supports is
+// bound by a load-time constructor (MY_SCANF_KERNELS=<name> in the
+// environment overrides the choice); until then the portable set is used.
+typedef struct {
+    my_scanf_kernel_set kernels;
+    int (*supported)(void);
+} KernelChoice;
+
+static int always_supported(void) {
+    return 1;
+}
+
+#ifdef SCAN_KERNELS_X86
+static int cpu_has_avx512bw(void) {
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+}
+
+static int cpu_has_avx2(void) {
+    return __builtin_cpu_supports("avx2");
+}
+
+static int cpu_has_sse42(void) {
+    return __builtin_cpu_supports("sse4.2");
+}
+#endif
+
+static const KernelChoice kernel_choices[] = {
+#ifdef SCAN_KERNELS_X86
+    { { "avx512bw", span_whitespace_avx512, span_digits_avx512, span_hex_digits_avx512,
+        fold_binary_digits_avx512, translate_cipher_avx2 }, cpu_has_avx512bw },
+    { { "avx2", span_whitespace_avx2, span_digits_avx2, span_hex_digits_avx2,
+        fold_binary_digits_avx2, translate_cipher_avx2 }, cpu_has_avx2 },
+    { { "sse4.2", span_whitespace_sse42, span_digits_sse2, span_hex_digits_sse42,
+        fold_binary_digits_sse2, translate_cipher_sse2 }, cpu_has_sse42 },
+    { { "sse2", span_whitespace_sse2, span_digits_sse2, span_hex_digits_sse2,
+        fold_binary_digits_sse2, translate_cipher_sse2 }, always_supported },
+#endif
+    { { "scalar", span_whitespace_scalar, span_digits_scalar, span_hex_digits_scalar,
+        fold_binary_digits_scalar, translate_cipher_scalar }, always_supported },
+};
+#define NUM_KERNEL_CHOICES ((int)(sizeof(kernel_choices) / sizeof(kernel_choices[0])))
+
+my_scanf_kernel_set my_scanf_active_kernels = {
+    "scalar", span_whitespace_scalar, span_digits_scalar, span_hex_digits_scalar,
+    fold_binary_digits_scalar, translate_cipher_scalar
+};
+
+int my_scanf_use_kernels(const char *name) {
+#ifdef SCAN_KERNELS_X86
+    __builtin_cpu_init();
+#endif
+    for (int i = 0; i < NUM_KERNEL_CHOICES; i++) {
+        const KernelChoice *choice = &kernel_choices[i];
+        if (name != NULL && strcmp(name, choice->kernels.name) != 0) {
+            continue;
+        }
+        if (!choice->supported()) {
+            if (name != NULL) {
+                return -1;
+            }
+            continue;
+        }
+        my_scanf_active_kernels = choice->kernels;
+        return 0;
+    }
+    return -1;
+}
+
+const char *my_scanf_kernels(void) {
+    return my_scanf_active_kernels.name;
+}
+
+__attribute__((constructor))
+static void select_scan_kernels(void) {
+    const char *forced = getenv("MY_SCANF_KERNELS");
+    if (forced == NULL || my_scanf_use_kernels(forced) != 0) {
+        my_scanf_use_kernels(NULL);
+    }
+}
@@ -0,0 +1,247 @@
+#include "my_scanf.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+
+// MULTIPLEXED STREAM SCANNING
+// A my_scanf_mux watches many descriptors with one epoll instance and runs
+// each through its own push parser (my_parser_feed), so a single thread can
+// parse thousands of slow streams without blocking on any of them. Records
+// are handed out through the stream's callback as soon as they complete.
+//
+// Streams are level-triggered and get one read per wakeup, so a stream that
+// never stops talking cannot starve the others. Regular files cannot be
+// registered with epoll (they are always readable); they are kept on a
+// separate list and read once per my_mux_run until they reach EOF.
+//
+// The mux is not thread safe: for more than one thread, give each its own mux
+// and spread the descriptors across them.
+#define MUX_READ_SIZE  (64 * 1024)
+#define MUX_MAX_EVENTS 256
+
+typedef struct MuxStream MuxStream;
+
+struct MuxStream {
+    int fd;
+    my_scanf_parser *parser;
+    my_mux_callback callback;
+    void *user;
+    int polled;          // registered with epoll (0 for regular files)
+    int removed;         // waiting to be freed at the end of my_mux_run
+    MuxStream *next;     // regular file list
+    MuxStream *next_removed;
+};
+
+struct my_scanf_mux {
+    int epfd;
+    MuxStream **by_fd;   // indexed by descriptor
+    int by_fd_cap;
+    int count;           // registered streams
+    MuxStream *files;    // regular files, read on every my_mux_run
+    MuxStream *removed;  // removed while dispatching, freed afterwards
+    int dispatching;
+    char buf[MUX_READ_SIZE];
+};
+
+my_scanf_mux *my_mux_new(void) {
+    my_scanf_mux *mx = calloc(1, sizeof(*mx));
+    if (mx == NULL) {
+        return NULL;
+    }
+    mx->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (mx->epfd < 0) {
+        free(mx);
+        return NULL;
+    }
+    return mx;
+}
+
+static void stream_free(MuxStream *st) {
+    my_parser_close(st->parser);
+    free(st);
+}
+
+void my_mux_free(my_scanf_mux *mx) {
+    if (mx == NULL) {
+        return;
+    }
+    for (int fd = 0; fd < mx->by_fd_cap; fd++) {
+        if (mx->by_fd[fd] != NULL) {
+            stream_free(mx->by_fd[fd]);
+        }
+    }
+    while (mx->removed != NULL) {
+        MuxStream *st = mx->removed;
+        mx->removed = st->next_removed;
+        stream_free(st);
+    }
+    close(mx->epfd);
+    free(mx->by_fd);
+    free(mx);
+}
+
+// Makes room in the descriptor table for fd. Returns 0, or -1 if memory runs out.
+static int mux_reserve(my_scanf_mux *mx, int fd) {
+    if (fd < mx->by_fd_cap) {
+        return 0;
+    }
+    int cap = (mx->by_fd_cap > 0) ? mx->by_fd_cap : 64;
+    while (cap <= fd) {
+        cap *= 2;
+    }
+    MuxStream **by_fd = realloc(mx->by_fd, (size_t)cap * sizeof(*by_fd));
+    if (by_fd == NULL) {
+        return -1;
+    }
+    memset(by_fd + mx->by_fd_cap, 0, (size_t)(cap - mx->by_fd_cap) * sizeof(*by_fd));
+    mx->by_fd = by_fd;
+    mx->by_fd_cap = cap;
+    return 0;
+}
+
+int my_mux_add(my_scanf_mux *mx, int fd, const char *format, void *dests[],
+               my_mux_callback callback, void *user) {
+    if (fd < 0 || callback == NULL || mux_reserve(mx, fd) != 0 || mx->by_fd[fd] != NULL) {
+        return -1;
+    }
+
+    MuxStream *st = calloc(1, sizeof(*st));
+    if (st == NULL) {
+        return -1;
+    }
+    st->parser = my_parser_open(format, dests);
+    if (st->parser == NULL) {
+        free(st);
+        return -1;
+    }
+    st->fd = fd;
+    st->callback = callback;
+    st->user = user;
+
+    // Reads must never block the loop
+    int fl = fcntl(fd, F_GETFL);
+    if (fl < 0 || fcntl(fd, F_SETFL, fl | O_NONBLOCK) < 0) {
+        stream_free(st);
+        return -1;
+    }
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = st };
+    if (epoll_ctl(mx->epfd, EPOLL_CTL_ADD, fd, &ev) == 0) {
+        st->polled = 1;
+    } else if (errno == EPERM) {
+        // Regular file: always readable, so poll it by hand
+        st->next = mx->files;
+        mx->files = st;
+    } else {
+        stream_free(st);
+        return -1;
+    }
+
+    mx->by_fd[fd] = st;
+    mx->count++;
+    return 0;
+}
+
+int my_mux_remove(my_scanf_mux *mx, int fd) {
+    if (fd < 0 || fd >= mx->by_fd_cap || mx->by_fd[fd] == NULL) {
+        return -1;
+    }
+    MuxStream *st = mx->by_fd[fd];
+    mx->by_fd[fd] = NULL;
+    mx->count--;
+
+    if (st->polled) {
+        epoll_ctl(mx->epfd, EPOLL_CTL_DEL, fd, NULL);
+    } else {
+        MuxStream **link = &mx->files;
+        while (*link != st) {
+            link = &(*link)->next;
+        }
+        *link = st->next;
+    }
+
+    // Events for it may still be pending in the batch being dispatched
+    if (mx->dispatching) {
+        st->removed = 1;
+        st->next_removed = mx->removed;
+        mx->removed = st;
+    } else {
+        stream_free(st);
+    }
+    return 0;
+}
+
+int my_mux_count(const my_scanf_mux *mx) {
+    return mx->count;
+}
+
+// Hands every complete record the parser holds to the callback
+static void stream_deliver(MuxStream *st, int status) {
+    while (!st->removed && (status == MY_PARSE_RECORD || status == MY_PARSE_ERROR)) {
+        st->callback(st->user, st->fd, status);
+        if (st->removed) {
+            return;
+        }
+        status = my_parser_feed(st->parser, NULL, 0);
+    }
+}
+
+// One read from the stream. At EOF (or on a read error) the last record is
+// flushed, the callback sees MY_PARSE_END and the stream is removed; the
+// descriptor itself is left open for the caller.
+static void stream_read(my_scanf_mux *mx, MuxStream *st) {
+    ssize_t n = read(st->fd, mx->buf, sizeof(mx->buf));
+    if (n > 0) {
+        stream_deliver(st, my_parser_feed(st->parser, mx->buf, (size_t)n));
+        return;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return;
+    }
+
+    int fd = st->fd;
+    stream_deliver(st, my_parser_finish(st->parser));
+    if (!st->removed) {
+        my_mux_remove(mx, fd);
+        st->callback(st->user, fd, MY_PARSE_END);
+    }
+}
+
+int my_mux_run(my_scanf_mux *mx, int timeout_ms) {
+    if (mx->count == 0) {
+        return 0;
+    }
+
+    // Regular files always have something to read, so don't sleep on them
+    struct epoll_event events[MUX_MAX_EVENTS];
+    int n = epoll_wait(mx->epfd, events, MUX_MAX_EVENTS, mx->files != NULL ? 0 : timeout_ms);
+    if (n < 0 && errno != EINTR) {
+        return -1;
+    }
+
+    mx->dispatching = 1;
+    for (int k = 0; k < n; k++) {
+        MuxStream *st = events[k].data.ptr;
+        if (!st->removed) {
+            stream_read(mx, st);
+        }
+    }
+    // A removed file keeps its next link until it is freed below
+    for (MuxStream *st = mx->files; st != NULL; st = st->next) {
+        if (!st->removed) {
+            stream_read(mx, st);
+        }
+    }
+    mx->dispatching = 0;
+
+    while (mx->removed != NULL) {
+        MuxStream *dead = mx->removed;
+        mx->removed = dead->next_removed;
+        stream_free(dead);
+    }
+    return mx->count;
+}
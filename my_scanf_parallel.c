@@ -0,0 +1,264 @@
+#include "my_scanf.h"
+#include "my_scanf_internal.h"
+#include <ctype.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+// PARALLEL CHUNKED SCANNING
+// my_scan_columns_parallel maps a file with my_mmap_open, cuts it into chunks
+// that each end on a newline, and lets a pool of worker threads run the
+// compiled format over the chunks (the same column scanner as
+// my_scan_columns, over a memory range).
+//
+// It takes two passes over the chunks. The first counts each chunk's lines,
+// which bound its rows, so every chunk gets a fixed row offset into the
+// caller's columns. The second scans each chunk straight to its offset;
+// chunks that start at or past n are never scanned. Blank lines leave a
+// chunk short of its bound, so afterwards the rows are slid down over any
+// gaps in file order. The room those gaps give back is filled by scanning on
+// from the first chunk that did not fit, on the calling thread. Rows past
+// the returned count may have been written by chunks after a bad record.
+//
+// The result is exactly what one sequential my_scan_columns pass would give,
+// provided no record spans a newline: a chunk that hits a bad record stops
+// the scan there, just like the sequential scan stops.
+#define PARALLEL_MIN_CHUNK (1 << 20)      // not worth splitting below 1 MiB
+#define PARALLEL_CHUNKS_PER_THREAD 4      // spare chunks smooth out uneven lines
+
+typedef struct {
+    const char *start;
+    size_t len;
+    size_t lines;         // rows this chunk can produce at most
+    long offset;          // first row of the caller's columns it writes to
+    void **cols;          // cols[k] + offset rows
+    int records;          // complete records scanned
+    size_t consumed;      // bytes those records took
+    int clean;            // 1 if nothing but whitespace followed the last record
+    int capped;           // 1 if n cut the chunk short of its line count
+} Chunk;
+
+typedef struct {
+    const my_scanf_program *prog;
+    Chunk *chunks;
+    int num_chunks;
+    long n;               // rows the caller has room for
+    atomic_int next_chunk;
+} ParallelJob;
+
+static size_t count_newlines(const char *p, size_t len) {
+    const char *end = p + len;
+    size_t lines = 0;
+    while ((p = memchr(p, '\n', (size_t)(end - p))) != NULL) {
+        lines++;
+        p++;
+    }
+    return lines;
+}
+
+// Every record ends on a newline (or at the end of the chunk), so the line
+// count bounds how many rows the chunk can produce
+static void count_chunk(Chunk *chunk) {
+    chunk->lines = count_newlines(chunk->start, chunk->len);
+    if (chunk->len > 0 && chunk->start[chunk->len - 1] != '\n') {
+        chunk->lines++;
+    }
+}
+
+static void scan_chunk(const my_scanf_program *prog, Chunk *chunk, long n) {
+    if (chunk->offset >= n) {
+        chunk->capped = 1;  // no room left at its offset
+        return;
+    }
+    size_t rows = chunk->lines;
+    if (rows > (size_t)(n - chunk->offset)) {
+        rows = (size_t)(n - chunk->offset);
+    }
+    if (rows > INT_MAX) {
+        rows = INT_MAX;
+    }
+    chunk->capped = (rows < chunk->lines);
+
+    chunk->records = my_scan_columns_range(chunk->start, chunk->len, prog, (int)rows,
+                                           chunk->cols, &chunk->consumed);
+
+    chunk->clean = 1;
+    for (size_t i = chunk->consumed; i < chunk->len; i++) {
+        if (!isspace((unsigned char)chunk->start[i])) {
+            chunk->clean = 0;
+            break;
+        }
+    }
+}
+
+static void *count_worker(void *arg) {
+    ParallelJob *job = arg;
+    for (;;) {
+        int i = atomic_fetch_add(&job->next_chunk, 1);
+        if (i >= job->num_chunks) {
+            break;
+        }
+        count_chunk(&job->chunks[i]);
+    }
+    return NULL;
+}
+
+static void *scan_worker(void *arg) {
+    ParallelJob *job = arg;
+    for (;;) {
+        int i = atomic_fetch_add(&job->next_chunk, 1);
+        if (i >= job->num_chunks) {
+            break;
+        }
+        scan_chunk(job->prog, &job->chunks[i], job->n);
+    }
+    return NULL;
+}
+
+// Runs worker over every chunk on nthreads threads, the calling thread
+// being one of them
+static void run_workers(ParallelJob *job, int nthreads, void *(*worker)(void *)) {
+    atomic_store(&job->next_chunk, 0);
+    pthread_t *threads = calloc((size_t)nthreads, sizeof(pthread_t));
+    int started = 0;
+    for (int t = 1; threads != NULL && t < nthreads; t++) {
+        if (pthread_create(&threads[started], NULL, worker, job) != 0) {
+            break;
+        }
+        started++;
+    }
+    worker(job);
+    for (int t = 0; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    free(threads);
+}
+
+// Cuts [base, base + len) into at most max_chunks pieces ending on '\n'.
+// Returns the number of chunks written to chunks[].
+static int split_at_newlines(const char *base, size_t len, Chunk *chunks, int max_chunks) {
+    size_t target = len / (size_t)max_chunks;
+    if (target < PARALLEL_MIN_CHUNK) {
+        target = PARALLEL_MIN_CHUNK;
+    }
+
+    int count = 0;
+    size_t pos = 0;
+    while (pos < len && count < max_chunks) {
+        size_t end = len;
+        if (count < max_chunks - 1 && len - pos > target) {
+            const char *nl = memchr(base + pos + target, '\n', len - pos - target);
+            end = (nl != NULL) ? (size_t)(nl - base) + 1 : len;
+        }
+        memset(&chunks[count], 0, sizeof(Chunk));
+        chunks[count].start = base + pos;
+        chunks[count].len = end - pos;
+        count++;
+        pos = end;
+    }
+    return count;
+}
+
+long my_scan_columns_parallel(const char *path, const char *format, long n,
+                              void *cols[], int nthreads) {
+    my_scanf_mmap *file = my_mmap_open(path, 0);
+    if (file == NULL) {
+        return -1;
+    }
+    size_t len;
+    const char *base = my_mmap_data(file, &len);
+    if (len == 0 || n <= 0) {
+        my_mmap_close(file);
+        return 0;
+    }
+
+    my_scanf_program *prog = my_scanf_compile(format);
+    if (nthreads <= 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = (online > 0) ? (int)online : 1;
+    }
+    int max_chunks = nthreads * PARALLEL_CHUNKS_PER_THREAD;
+    Chunk *chunks = calloc((size_t)max_chunks, sizeof(Chunk));
+    // Rows scanned past the first bad record are thrown away, and with them
+    // any %mq / %mz strings, so allocating formats are not supported here.
+    // Nor is %v: the file is unmapped before we return, and views would
+    // point into it.
+    if (prog == NULL || chunks == NULL || my_scanf_program_allocates(prog) ||
+        my_scanf_program_has_views(prog)) {
+        my_scanf_free(prog);
+        free(chunks);
+        my_mmap_close(file);
+        return -1;
+    }
+
+    ParallelJob job = { .prog = prog, .chunks = chunks, .n = n };
+    job.num_chunks = split_at_newlines(base, len, chunks, max_chunks);
+    atomic_init(&job.next_chunk, 0);
+    if (nthreads > job.num_chunks) {
+        nthreads = job.num_chunks;
+    }
+
+    // Line counts give every chunk its place in the caller's columns
+    int num_cols = my_scanf_program_num_dests(prog);
+    void **dests = calloc((size_t)job.num_chunks * (size_t)(num_cols > 0 ? num_cols : 1),
+                          sizeof(void *));
+    if (dests == NULL) {
+        free(chunks);
+        my_scanf_free(prog);
+        my_mmap_close(file);
+        return -1;
+    }
+    run_workers(&job, nthreads, count_worker);
+    long offset = 0;
+    for (int i = 0; i < job.num_chunks; i++) {
+        Chunk *chunk = &chunks[i];
+        chunk->offset = offset;
+        chunk->cols = dests + (size_t)i * (size_t)num_cols;
+        for (int k = 0; k < num_cols && offset < n; k++) {
+            chunk->cols[k] = (char *)cols[k] + (size_t)offset * my_scanf_program_dest_size(prog, k);
+        }
+        offset = (chunk->lines < (size_t)(LONG_MAX - offset)) ? offset + (long)chunk->lines : LONG_MAX;
+    }
+    run_workers(&job, nthreads, scan_worker);
+
+    // Slide the rows down over the gaps short chunks left, in file order
+    long total = 0;
+    for (int i = 0; i < job.num_chunks && total < n; i++) {
+        Chunk *chunk = &chunks[i];
+        if (chunk->offset != total && chunk->records > 0) {
+            for (int k = 0; k < num_cols; k++) {
+                size_t size = my_scanf_program_dest_size(prog, k);
+                memmove((char *)cols[k] + (size_t)total * size, chunk->cols[k],
+                        (size_t)chunk->records * size);
+            }
+        }
+        total += chunk->records;
+        if (chunk->capped) {
+            // The chunk stopped at its line-count room (or, starting past n,
+            // was never scanned), but earlier chunks came up short, so there
+            // may be room left: go on from where it stopped
+            const char *rest = chunk->start + chunk->consumed;
+            long room = (n - total < INT_MAX) ? n - total : INT_MAX;
+            for (int k = 0; k < num_cols; k++) {
+                chunk->cols[k] = (char *)cols[k] + (size_t)total * my_scanf_program_dest_size(prog, k);
+            }
+            size_t consumed;
+            total += (room <= 0) ? 0 : my_scan_columns_range(rest, (size_t)(base + len - rest), prog, (int)room,
+                                           chunk->cols, &consumed);
+            break;
+        }
+        if (!chunk->clean) {
+            break;  // a bad record ends the scan, as in the sequential version
+        }
+    }
+
+    free(dests);
+    free(chunks);
+    my_scanf_free(prog);
+    my_mmap_close(file);
+    return total;
+}
@@ -0,0 +1,230 @@
+#include "my_scanf_internal.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+// READER THREAD PIPELINE
+// The portable alternative to io_uring read-ahead: a dedicated thread sits
+// in read(2) on the descriptor and fills a ring of large buffers, and the
+// parsing thread takes them in order through a single-producer,
+// single-consumer queue. While there is data queued, handing a buffer over
+// costs the parser two atomic loads and a store - no syscalls and no locks -
+// so read latency (a `zcat |` upstream, a slow pipe) overlaps with parsing.
+//
+// Only when one side has to wait (queue empty or full) does it spin briefly
+// and then sleep on a condition variable. Each side publishes a "waiting"
+// flag before its final check, and the other side looks at the flag after
+// publishing its own progress, so a wakeup is never lost and the lock is
+// never touched while both keep up.
+#define PIPELINE_DEFAULT_BUFFERS 4
+#define PIPELINE_MAX_BUFFERS     64
+#define PIPELINE_DEFAULT_SIZE    (128 * 1024)
+#define PIPELINE_BUFFER_ALIGN    64
+#define PIPELINE_SPIN            1024
+
+typedef struct {
+    char *data;          // MY_READER_HEADROOM bytes after the slot start
+    size_t len;          // 0 marks EOF or a read error
+    int error;           // errno of the failed read when len is 0, else 0
+} PipelineSlot;
+
+typedef struct {
+    my_buffer_reader base;
+    int fd;
+    int nbuffers;
+    size_t size;
+    char *arena;
+    PipelineSlot slots[PIPELINE_MAX_BUFFERS];
+
+    // Slots [head, tail) are filled and waiting for the parser. Both only
+    // ever grow; the slot index is the count modulo nbuffers.
+    _Alignas(64) atomic_size_t head;   // written by the parser
+    _Alignas(64) atomic_size_t tail;   // written by the reader thread
+    _Alignas(64) atomic_int parser_waiting;
+    atomic_int reader_waiting;
+    atomic_int stop;
+    int holding;         // the parser still has slot head checked out
+    int eof;
+    int error;           // errno the reader thread's last read(2) failed with
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_t thread;
+} ThreadReader;
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// Sleeps until ready(r) holds. The flag is raised before the final check so
+// that the other side either sees it or we see its progress.
+static void pipeline_wait(ThreadReader *r, atomic_int *waiting, int (*ready)(ThreadReader *)) {
+    for (int spin = 0; spin < PIPELINE_SPIN; spin++) {
+        if (ready(r)) {
+            return;
+        }
+        cpu_relax();
+    }
+    pthread_mutex_lock(&r->lock);
+    atomic_store(waiting, 1);
+    while (!ready(r)) {
+        pthread_cond_wait(&r->wake, &r->lock);
+    }
+    atomic_store(waiting, 0);
+    pthread_mutex_unlock(&r->lock);
+}
+
+static void pipeline_wake(ThreadReader *r, atomic_int *waiting) {
+    if (atomic_load(waiting)) {
+        pthread_mutex_lock(&r->lock);
+        pthread_cond_broadcast(&r->wake);
+        pthread_mutex_unlock(&r->lock);
+    }
+}
+
+static int slot_free(ThreadReader *r) {
+    return atomic_load(&r->tail) - atomic_load(&r->head) < (size_t)r->nbuffers ||
+           atomic_load(&r->stop);
+}
+
+static int slot_filled(ThreadReader *r) {
+    return atomic_load(&r->tail) != atomic_load_explicit(&r->head, memory_order_relaxed);
+}
+
+static void *pipeline_thread(void *arg) {
+    ThreadReader *r = arg;
+    // Cancellation is only allowed inside read(2), which may block for good
+    // on a quiet pipe; everywhere else the thread may hold the lock
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+
+    for (;;) {
+        pipeline_wait(r, &r->reader_waiting, slot_free);
+        if (atomic_load(&r->stop)) {
+            break;
+        }
+
+        size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+        PipelineSlot *slot = &r->slots[tail % (size_t)r->nbuffers];
+        ssize_t n;
+        pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+        do {
+            n = read(r->fd, slot->data, r->size);
+        } while (n < 0 && errno == EINTR);
+        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+
+        slot->len = (n > 0) ? (size_t)n : 0;
+        slot->error = (n < 0) ? errno : 0;
+        atomic_store(&r->tail, tail + 1);
+        pipeline_wake(r, &r->parser_waiting);
+        if (n <= 0) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+// errno belongs to the reader thread, so a failed read is carried over in
+// its slot and raised again here, on the parsing thread. The scan then ends
+// the way my_fdscanf's does on the same error: EOF with errno set.
+static size_t thread_next(my_buffer_reader *base, char **data) {
+    ThreadReader *r = (ThreadReader *)base;
+    if (r->eof) {
+        if (r->error != 0) {
+            errno = r->error;
+        }
+        return 0;
+    }
+    // The buffer handed out last time goes back to the reader thread
+    if (r->holding) {
+        atomic_store(&r->head, atomic_load_explicit(&r->head, memory_order_relaxed) + 1);
+        pipeline_wake(r, &r->reader_waiting);
+        r->holding = 0;
+    }
+
+    pipeline_wait(r, &r->parser_waiting, slot_filled);
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    PipelineSlot *slot = &r->slots[head % (size_t)r->nbuffers];
+    if (slot->len == 0) {
+        r->eof = 1;
+        r->error = slot->error;
+        if (r->error != 0) {
+            errno = r->error;
+        }
+        return 0;
+    }
+    r->holding = 1;
+    *data = slot->data;
+    return slot->len;
+}
+
+static void thread_close(my_buffer_reader *base) {
+    ThreadReader *r = (ThreadReader *)base;
+    atomic_store(&r->stop, 1);
+    pthread_mutex_lock(&r->lock);
+    pthread_cond_broadcast(&r->wake);
+    pthread_mutex_unlock(&r->lock);
+    pthread_cancel(r->thread);   // only takes effect inside read(2)
+    pthread_join(r->thread, NULL);
+
+    pthread_cond_destroy(&r->wake);
+    pthread_mutex_destroy(&r->lock);
+    free(r->arena);
+    free(r);
+}
+
+my_buffer_reader *my_thread_reader_open(int fd, int nbuffers, size_t buffer_size) {
+    if (fd < 0) {
+        return NULL;
+    }
+    if (nbuffers <= 0) {
+        nbuffers = PIPELINE_DEFAULT_BUFFERS;
+    }
+    if (nbuffers > PIPELINE_MAX_BUFFERS) {
+        nbuffers = PIPELINE_MAX_BUFFERS;
+    }
+    if (buffer_size == 0) {
+        buffer_size = PIPELINE_DEFAULT_SIZE;
+    }
+    buffer_size = (buffer_size + PIPELINE_BUFFER_ALIGN - 1) & ~(size_t)(PIPELINE_BUFFER_ALIGN - 1);
+
+    ThreadReader *r = aligned_alloc(64, (sizeof(ThreadReader) + 63) & ~(size_t)63);
+    size_t stride = MY_READER_HEADROOM + buffer_size;
+    char *arena = aligned_alloc(PIPELINE_BUFFER_ALIGN, stride * (size_t)nbuffers);
+    if (r == NULL || arena == NULL) {
+        free(r);
+        free(arena);
+        return NULL;
+    }
+    memset(r, 0, sizeof(*r));
+    r->fd = fd;
+    r->nbuffers = nbuffers;
+    r->size = buffer_size;
+    r->arena = arena;
+    r->base.next = thread_next;
+    r->base.close = thread_close;
+    for (int k = 0; k < nbuffers; k++) {
+        r->slots[k].data = arena + (size_t)k * stride + MY_READER_HEADROOM;
+    }
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    atomic_init(&r->parser_waiting, 0);
+    atomic_init(&r->reader_waiting, 0);
+    atomic_init(&r->stop, 0);
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->wake, NULL);
+
+    if (pthread_create(&r->thread, NULL, pipeline_thread, r) != 0) {
+        pthread_cond_destroy(&r->wake);
+        pthread_mutex_destroy(&r->lock);
+        free(arena);
+        free(r);
+        return NULL;
+    }
+    return &r->base;
+}
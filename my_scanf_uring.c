@@ -0,0 +1,396 @@
+#include "my_scanf_internal.h"
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+
+
+// IO_URING READ-AHEAD
+// A UringReader keeps several reads of one descriptor in flight at once,
+// each into its own slot of a ring of buffers registered with the kernel.
+// The scanner parses slot N while the kernel is already filling N+1..N+k;
+// when it asks for the next slot, N goes straight back to the kernel for the
+// next stretch of the file. Without this, parsing and I/O take turns: every
+// refill waits out a full read(2) before the parser can continue.
+//
+// The ring is driven with the raw io_uring_setup/io_uring_enter syscalls,
+// so there is no liburing dependency. Regular files are read at explicit
+// offsets with depth reads in flight; pipes, sockets and terminals have no
+// offsets and reads on them complete in whatever order the data arrives, so
+// they get a single read in flight (which still overlaps with parsing).
+// Where io_uring is unavailable (old kernels, seccomp filters) the reader
+// quietly falls back to plain read(2) into the same buffers.
+#define URING_DEFAULT_DEPTH  4
+#define URING_MAX_DEPTH      64
+#define URING_BUFFER_ALIGN   64
+#define URING_CANCEL_TAG     UINT64_MAX
+
+typedef struct {
+    char *data;          // MY_READER_HEADROOM bytes after the slot start
+    off_t off;           // file offset the read was issued at
+    int busy;            // read in flight
+    int res;             // completion result: bytes read or -errno
+} UringSlot;
+
+typedef struct {
+    my_buffer_reader base;
+    int fd;
+    int ring_fd;         // -1 when falling back to read(2)
+    int regular;         // regular file: explicit offsets, full depth
+    int depth;
+    size_t size;         // bytes per read
+    char *arena;
+    UringSlot *slots;
+    int next;            // slot the scanner gets next, in file order
+    int last;            // slot handed out last time, -1 before the first
+    off_t submit_off;    // offset for the next read issued
+    off_t pos;           // offset of the first byte not handed out yet
+    int resync;          // a short read left later slots at the wrong offsets
+    int eof;
+    int error;           // errno of the read (or io_uring call) that ended it
+
+    // Kernel rings
+    void *sq_ring, *cq_ring;
+    size_t sq_ring_size, cq_ring_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    unsigned *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_cqe *cqes;
+    unsigned sq_local_tail;  // SQEs filled in, published by uring_enter
+    unsigned to_submit;  // queued SQEs not yet passed to io_uring_enter
+    int fixed;           // buffers registered, use READ_FIXED
+} UringReader;
+
+static int uring_setup(UringReader *r) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    r->ring_fd = (int)syscall(__NR_io_uring_setup, (unsigned)(2 * r->depth), &p);
+    if (r->ring_fd < 0) {
+        return -1;
+    }
+
+    r->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (r->cq_ring_size > r->sq_ring_size) {
+            r->sq_ring_size = r->cq_ring_size;
+        }
+        r->cq_ring_size = 0;
+    }
+    r->sq_ring = mmap(NULL, r->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      r->ring_fd, IORING_OFF_SQ_RING);
+    if (r->sq_ring == MAP_FAILED) {
+        r->sq_ring = NULL;
+        return -1;
+    }
+    r->cq_ring = r->sq_ring;
+    if (r->cq_ring_size > 0) {
+        r->cq_ring = mmap(NULL, r->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          r->ring_fd, IORING_OFF_CQ_RING);
+        if (r->cq_ring == MAP_FAILED) {
+            r->cq_ring = NULL;
+            return -1;
+        }
+    }
+    r->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = mmap(NULL, r->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   r->ring_fd, IORING_OFF_SQES);
+    if (r->sqes == MAP_FAILED) {
+        r->sqes = NULL;
+        return -1;
+    }
+
+    char *sq = r->sq_ring;
+    char *cq = r->cq_ring;
+    r->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    r->sq_local_tail = *r->sq_tail;
+    r->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    r->sq_array = (unsigned *)(sq + p.sq_off.array);
+    r->cq_head = (unsigned *)(cq + p.cq_off.head);
+    r->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    r->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+    // Registered buffers save the kernel pinning the pages on every read.
+    // Not fatal if it fails (RLIMIT_MEMLOCK), plain READ works on any buffer.
+    struct iovec iov[URING_MAX_DEPTH];
+    for (int k = 0; k < r->depth; k++) {
+        iov[k].iov_base = r->slots[k].data;
+        iov[k].iov_len = r->size;
+    }
+    r->fixed = (syscall(__NR_io_uring_register, r->ring_fd, IORING_REGISTER_BUFFERS,
+                        iov, (unsigned)r->depth) == 0);
+    return 0;
+}
+
+static void uring_teardown(UringReader *r) {
+    if (r->sqes != NULL) {
+        munmap(r->sqes, r->sqes_size);
+    }
+    if (r->cq_ring != NULL && r->cq_ring != r->sq_ring) {
+        munmap(r->cq_ring, r->cq_ring_size);
+    }
+    if (r->sq_ring != NULL) {
+        munmap(r->sq_ring, r->sq_ring_size);
+    }
+    if (r->ring_fd >= 0) {
+        close(r->ring_fd);
+    }
+    r->ring_fd = -1;
+}
+
+static struct io_uring_sqe *uring_get_sqe(UringReader *r) {
+    unsigned idx = r->sq_local_tail++ & *r->sq_mask;
+    struct io_uring_sqe *sqe = &r->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    r->sq_array[idx] = idx;
+    r->to_submit++;
+    return sqe;
+}
+
+// Queues a read of the stretch at off into slot k
+static void uring_queue_read_at(UringReader *r, int k, off_t off) {
+    UringSlot *slot = &r->slots[k];
+    struct io_uring_sqe *sqe = uring_get_sqe(r);
+    sqe->opcode = r->fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+    sqe->fd = r->fd;
+    sqe->addr = (uint64_t)(uintptr_t)slot->data;
+    sqe->len = (unsigned)r->size;
+    sqe->off = r->regular ? (uint64_t)off : (uint64_t)-1;  // -1 = current position
+    sqe->buf_index = r->fixed ? (uint16_t)k : 0;
+    sqe->user_data = (uint64_t)k;
+
+    slot->off = off;
+    slot->busy = 1;
+}
+
+// Queues the read that refills slot k with the next stretch of input
+static void uring_queue_read(UringReader *r, int k) {
+    uring_queue_read_at(r, k, r->submit_off);
+    if (r->regular) {
+        r->submit_off += (off_t)r->size;
+    }
+}
+
+// Submits whatever is queued and, with wait set, blocks for at least one
+// completion. Returns 0, or -1 if the ring itself failed.
+static int uring_enter(UringReader *r, int wait) {
+    __atomic_store_n(r->sq_tail, r->sq_local_tail, __ATOMIC_RELEASE);
+    long ret = syscall(__NR_io_uring_enter, r->ring_fd, r->to_submit, wait ? 1u : 0u,
+                       wait ? IORING_ENTER_GETEVENTS : 0u, NULL, 0);
+    if (ret < 0) {
+        return (errno == EINTR || errno == EAGAIN || errno == EBUSY) ? 0 : -1;
+    }
+    r->to_submit -= (unsigned)ret;
+    return 0;
+}
+
+static void uring_reap(UringReader *r) {
+    unsigned head = *r->cq_head;
+    unsigned tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        const struct io_uring_cqe *cqe = &r->cqes[head & *r->cq_mask];
+        if (cqe->user_data != URING_CANCEL_TAG) {
+            UringSlot *slot = &r->slots[cqe->user_data];
+            slot->res = cqe->res;
+            slot->busy = 0;
+        }
+        head++;
+    }
+    __atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+}
+
+// Returns 0 once slot k's read has completed, -1 if the ring failed
+static int uring_wait(UringReader *r, int k) {
+    for (;;) {
+        uring_reap(r);
+        if (!r->slots[k].busy) {
+            return 0;
+        }
+        if (uring_enter(r, 1) != 0) {
+            return -1;
+        }
+    }
+}
+
+// Waits out every read in flight. Pipe reads may never complete on their
+// own, so those are cancelled first.
+static int uring_drain(UringReader *r) {
+    int cancel = !r->regular;
+    for (int k = 0; k < r->depth; k++) {
+        if (r->slots[k].busy && cancel) {
+            struct io_uring_sqe *sqe = uring_get_sqe(r);
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->addr = (uint64_t)k;
+            sqe->user_data = URING_CANCEL_TAG;
+        }
+    }
+    for (int k = 0; k < r->depth; k++) {
+        if (r->slots[k].busy && uring_wait(r, k) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static size_t uring_next(my_buffer_reader *base, char **data);
+static void uring_close(my_buffer_reader *base);
+
+my_buffer_reader *my_uring_reader_open(int fd, int depth, size_t buffer_size) {
+    if (fd < 0) {
+        return NULL;
+    }
+    if (depth <= 0) {
+        depth = URING_DEFAULT_DEPTH;
+    }
+    if (depth > URING_MAX_DEPTH) {
+        depth = URING_MAX_DEPTH;
+    }
+    if (buffer_size == 0) {
+        buffer_size = 64 * 1024;
+    }
+    buffer_size = (buffer_size + URING_BUFFER_ALIGN - 1) & ~(size_t)(URING_BUFFER_ALIGN - 1);
+
+    struct stat st;
+    UringReader *r = calloc(1, sizeof(*r));
+    if (r == NULL || fstat(fd, &st) != 0) {
+        free(r);
+        return NULL;
+    }
+    r->base.next = uring_next;
+    r->base.close = uring_close;
+    r->fd = fd;
+    r->ring_fd = -1;
+    r->last = -1;
+    r->size = buffer_size;
+    r->regular = S_ISREG(st.st_mode);
+    if (r->regular) {
+        r->submit_off = r->pos = lseek(fd, 0, SEEK_CUR);
+        r->regular = (r->pos >= 0);
+    }
+    r->depth = r->regular ? depth : 1;
+
+    size_t stride = MY_READER_HEADROOM + buffer_size;
+    r->arena = aligned_alloc(URING_BUFFER_ALIGN, stride * (size_t)r->depth);
+    r->slots = calloc((size_t)r->depth, sizeof(*r->slots));
+    if (r->arena == NULL || r->slots == NULL) {
+        free(r->arena);
+        free(r->slots);
+        free(r);
+        return NULL;
+    }
+    for (int k = 0; k < r->depth; k++) {
+        r->slots[k].data = r->arena + (size_t)k * stride + MY_READER_HEADROOM;
+    }
+
+    if (uring_setup(r) != 0) {
+        uring_teardown(r);
+        return &r->base;
+    }
+    for (int k = 0; k < r->depth; k++) {
+        uring_queue_read(r, k);
+    }
+    if (uring_enter(r, 0) != 0) {
+        uring_teardown(r);
+    }
+    return &r->base;
+}
+
+// Ends the input. A failure keeps its errno, which every later call raises
+// again, so the scan ends the way my_fdscanf's does: EOF with errno set.
+static size_t uring_fail(UringReader *r, int error) {
+    r->eof = 1;
+    r->error = error;
+    if (error != 0) {
+        errno = error;
+    }
+    return 0;
+}
+
+// Synchronous fallback: one read(2) into slot 0
+static size_t fallback_next(UringReader *r, char **data) {
+    ssize_t n;
+    do {
+        n = read(r->fd, r->slots[0].data, r->size);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) {
+        return uring_fail(r, (n < 0) ? errno : 0);
+    }
+    *data = r->slots[0].data;
+    return (size_t)n;
+}
+
+static size_t uring_next(my_buffer_reader *base, char **data) {
+    UringReader *r = (UringReader *)base;
+    if (r->eof) {
+        if (r->error != 0) {
+            errno = r->error;
+        }
+        return 0;
+    }
+    if (r->ring_fd < 0) {
+        return fallback_next(r, data);
+    }
+
+    // The slot handed out last time is done with; it reads the stretch after
+    // everything already in flight
+    if (r->last >= 0) {
+        if (r->resync) {
+            // A short read moved the file position: reissue every read in
+            // file order from where the input really continues
+            if (uring_drain(r) != 0) {
+                return uring_fail(r, errno);
+            }
+            r->submit_off = r->pos;
+            for (int k = 0; k < r->depth; k++) {
+                uring_queue_read(r, (r->next + k) % r->depth);
+            }
+            r->resync = 0;
+        } else {
+            uring_queue_read(r, r->last);
+        }
+        r->last = -1;
+    }
+
+    for (;;) {
+        UringSlot *slot = &r->slots[r->next];
+        if (uring_wait(r, r->next) != 0) {
+            return uring_fail(r, errno);
+        }
+        if (slot->res == -EINTR || slot->res == -EAGAIN) {
+            uring_queue_read_at(r, r->next, slot->off);
+            continue;
+        }
+        if (slot->res <= 0) {
+            return uring_fail(r, -slot->res);
+        }
+
+        size_t n = (size_t)slot->res;
+        if (r->regular && n < r->size) {
+            r->resync = 1;
+        }
+        r->pos += (off_t)n;
+        r->last = r->next;
+        r->next = (r->next + 1) % r->depth;
+        *data = slot->data;
+        return n;
+    }
+}
+
+static void uring_close(my_buffer_reader *base) {
+    UringReader *r = (UringReader *)base;
+    if (r->ring_fd >= 0) {
+        uring_drain(r);
+        uring_teardown(r);
+    }
+    free(r->slots);
+    free(r->arena);
+    free(r);
+}
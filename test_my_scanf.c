@@ -1,6 +1,12 @@
 #include "my_scanf.h"
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
 
 /*
     About the testing structure:
@@ -162,6 +168,36 @@ int check_string_match(int scanf_ret, int my_scanf_ret, const char *scanf_val, c
     }
 }
 
+// test_double_exact: %lf must be correctly rounded, so unlike the epsilon
+// comparisons above the two doubles have to be bit-for-bit identical.
+int test_double_exact(const char *name, const char *file) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+    printf("Input file: %s\n", file);
+
+    stdin = freopen(file, "r", stdin);
+    if (!stdin) { printf("FAIL: Can't open %s\n", file); tests_failed++; return 0; }
+
+    double scanf_val = -999.0, my_scanf_val = -999.0;
+    int scanf_ret = scanf("%lf", &scanf_val);
+    freopen("/dev/tty", "r", stdin);
+
+    printf("\tscanf()    returned: %d, value: %.17g\n", scanf_ret, scanf_val);
+
+    stdin = freopen(file, "r", stdin);
+    int my_scanf_ret = my_scanf("%lf", &my_scanf_val);
+    freopen("/dev/tty", "r", stdin);
+
+    printf("\tmy_scanf() returned: %d, value: %.17g\n", my_scanf_ret, my_scanf_val);
+
+    int passed = (scanf_ret == my_scanf_ret &&
+                  memcmp(&scanf_val, &my_scanf_val, sizeof(double)) == 0);
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
 // Helper for the test_binary function
 int manual_binary_to_int(const char *s) {
     int value = 0, sign = 1, i = 0;
@@ -171,6 +207,16 @@ int manual_binary_to_int(const char *s) {
     return value * sign;
 }
 
+// 64-bit version for %lb / %llb, wrapping modulo 2^64 like the readers
+long long manual_binary_to_llong(const char *s) {
+    unsigned long long value = 0;
+    int negative = 0, i = 0;
+    if (s[i] == '-') { negative = 1; i++; } else if (s[i] == '+') { i++; }
+    if (s[i] == '0' && (s[i+1] == 'b' || s[i+1] == 'B')) i += 2;
+    while (s[i] == '0' || s[i] == '1') value = value * 2 + (unsigned)(s[i++] - '0');
+    return (long long)(negative ? 0 - value : value);
+}
+
 // GENERIC TEST RUNNERS
 // test_... functions: Redirect input files to stdin, call scanf() and
 // my_scanf() with the same format, then compare results. Functions are
@@ -426,6 +472,37 @@ int test_binary(const char *name, const char *file) {
     return passed;
 }
 
+// test_binary_long: %lb / %llb (optionally with a width) into a long long,
+// checked against converting the first width characters of the token
+int test_binary_long(const char *name, const char *file, const char *fmt, int width) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+    printf("Input file: %s\n", file);
+    printf("Format: %s\n", fmt);
+
+    stdin = freopen(file, "r", stdin);
+    if (!stdin) { printf("FAIL: Can't open %s\n", file); tests_failed++; return 0; }
+    long long my_val = -999;
+    int my_ret = my_scanf(fmt, &my_val);
+    freopen("/dev/tty", "r", stdin);
+
+    stdin = freopen(file, "r", stdin);
+    char bin_str[100] = {0};
+    scanf("%99s", bin_str);
+    freopen("/dev/tty", "r", stdin);
+    if (width > 0) bin_str[width] = '\0';
+
+    long long manual_val = manual_binary_to_llong(bin_str);
+    printf("\tmy_scanf() returned: %d, value: %lld\n", my_ret, my_val);
+    printf("\tManual conversion of '%s': %lld\n", bin_str, manual_val);
+
+    int passed = (my_ret == 1 && my_val == manual_val);
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
 int test_genz(const char *name, const char *file, const char *fmt, const char *expected) {
     tests_run++;
     printf("\nTEST: %s\n", name);
@@ -923,6 +1000,1707 @@ int test_literal_percent(const char *name, const char *file, const char *fmt, in
     return passed;
 }
 
+// SOURCE FRONT END RUNNERS
+// test_frontends: Loads the input file into memory and runs the same format
+// through my_sscanf(), my_fscanf(), my_fdscanf() and my_mmscanf(). All of
+// them must agree with the system sscanf() on the same bytes.
+int test_frontends(const char *name, const char *file, const char *fmt) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+    printf("Input file: %s\n", file);
+    printf("Format: %s\n", fmt);
+
+    FILE *fp = fopen(file, "r");
+    if (!fp) { printf("FAIL: Can't open %s\n", file); tests_failed++; return 0; }
+    char text[1024] = {0};
+    size_t n = fread(text, 1, sizeof(text) - 1, fp);
+    text[n] = '\0';
+    rewind(fp);
+
+    int i_ref = -999, i_s = -999, i_f = -999, i_fd = -999, i_mm = -999;
+    float f_ref = -999.0f, f_s = -999.0f, f_f = -999.0f, f_fd = -999.0f, f_mm = -999.0f;
+    char s_ref[256] = {0}, s_s[256] = {0}, s_f[256] = {0}, s_fd[256] = {0}, s_mm[256] = {0};
+
+    int ref_ret = sscanf(text, fmt, &i_ref, &f_ref, s_ref);
+    int s_ret = my_sscanf(text, fmt, &i_s, &f_s, s_s);
+    int f_ret = my_fscanf(fp, fmt, &i_f, &f_f, s_f);
+    fclose(fp);
+
+    int fd = open(file, O_RDONLY);
+    int fd_ret = my_fdscanf(fd, fmt, &i_fd, &f_fd, s_fd);
+    my_fdscanf_release(fd);
+    close(fd);
+
+    my_scanf_mmap *mm = my_mmap_open(file, 0);
+    int mm_ret = mm ? my_mmscanf(mm, fmt, &i_mm, &f_mm, s_mm) : -999;
+    my_mmap_close(mm);
+
+    printf("\tsscanf()     returned: %d, values: %d %f '%s'\n", ref_ret, i_ref, f_ref, s_ref);
+    printf("\tmy_sscanf()  returned: %d, values: %d %f '%s'\n", s_ret, i_s, f_s, s_s);
+    printf("\tmy_fscanf()  returned: %d, values: %d %f '%s'\n", f_ret, i_f, f_f, s_f);
+    printf("\tmy_fdscanf() returned: %d, values: %d %f '%s'\n", fd_ret, i_fd, f_fd, s_fd);
+    printf("\tmy_mmscanf() returned: %d, values: %d %f '%s'\n", mm_ret, i_mm, f_mm, s_mm);
+
+    int passed = (ref_ret == s_ret && ref_ret == f_ret && ref_ret == fd_ret && ref_ret == mm_ret &&
+                  i_ref == i_s && i_ref == i_f && i_ref == i_fd && i_ref == i_mm &&
+                  f_ref == f_s && f_ref == f_f && f_ref == f_fd && f_ref == f_mm &&
+                  strcmp(s_ref, s_s) == 0 && strcmp(s_ref, s_f) == 0 &&
+                  strcmp(s_ref, s_fd) == 0 && strcmp(s_ref, s_mm) == 0);
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// test_file_position: Loops my_fscanf() and the system fscanf() over the
+// same records on two streams, across many stdio buffer refills. After every
+// call both streams must sit at the same offset - my_fscanf reads stdio's
+// buffer directly but may only consume what it parsed - and once a bad row
+// stops them, fgets() must see the same rest of the line on both.
+#define POSITION_ROWS 5000
+int test_file_position(const char *name, const char *fmt, int bad_row) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+    printf("Format: %s (%d rows)\n", fmt, POSITION_ROWS);
+
+    char path[] = "/tmp/my_scanf_position_XXXXXX";
+    int fd = mkstemp(path);
+    FILE *fp = (fd >= 0) ? fdopen(fd, "w") : NULL;
+    if (!fp) { printf("FAIL: Can't create %s\n", path); tests_failed++; return 0; }
+    for (int i = 0; i < POSITION_ROWS; i++) {
+        if (i == bad_row) fprintf(fp, "%d;oops row\n", i);
+        else fprintf(fp, "%d,%d.5 word%d\n", i, -i, i);
+    }
+    fclose(fp);
+
+    FILE *ref = fopen(path, "r");
+    FILE *mine = fopen(path, "r");
+    int passed = ref != NULL && mine != NULL;
+    int calls = 0;
+    while (passed) {
+        int i_ref = -1, i_my = -1;
+        float f_ref = 0.0f, f_my = 0.0f;
+        char s_ref[32] = {0}, s_my[32] = {0};
+        int ref_ret = fscanf(ref, fmt, &i_ref, &f_ref, s_ref);
+        int my_ret = my_fscanf(mine, fmt, &i_my, &f_my, s_my);
+        calls++;
+        passed = ref_ret == my_ret && ftell(ref) == ftell(mine) &&
+                 i_ref == i_my && f_ref == f_my && strcmp(s_ref, s_my) == 0;
+        if (ref_ret != 3) break;
+    }
+    char rest_ref[64] = {0}, rest_my[64] = {0};
+    if (passed) {
+        int got_ref = fgets(rest_ref, sizeof(rest_ref), ref) != NULL;
+        int got_my = fgets(rest_my, sizeof(rest_my), mine) != NULL;
+        passed = got_ref == got_my && strcmp(rest_ref, rest_my) == 0;
+    }
+    rest_ref[strcspn(rest_ref, "\n")] = '\0';
+    printf("\t%d calls, offsets %s, then '%s'\n", calls, passed ? "in step" : "diverged", rest_ref);
+
+    if (ref) fclose(ref);
+    if (mine) fclose(mine);
+    unlink(path);
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// test_mmap_records: Maps the file with the given my_mmap_open() flags and
+// loops my_mmscanf() over its records; every call must match looping the
+// system fscanf() with the same format over the same file.
+int test_mmap_records(const char *name, const char *file, const char *fmt, int flags) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+    printf("Input file: %s\n", file);
+    printf("Format: %s (flags 0x%x)\n", fmt, flags);
+
+    FILE *fp = fopen(file, "r");
+    my_scanf_mmap *mm = my_mmap_open(file, flags);
+    if (!fp || !mm) {
+        printf("FAIL: Can't set up %s\n", file);
+        if (fp) fclose(fp);
+        my_mmap_close(mm);
+        tests_failed++;
+        return 0;
+    }
+
+    int passed = 1;
+    int records = 0;
+    for (;;) {
+        int i1 = -999, i2 = -999;
+        float f1 = -999.0f, f2 = -999.0f;
+        char s1[256] = {0}, s2[256] = {0};
+        int ret1 = fscanf(fp, fmt, &i1, &f1, s1);
+        int ret2 = my_mmscanf(mm, fmt, &i2, &f2, s2);
+        if (ret1 != ret2 || i1 != i2 || f1 != f2 || strcmp(s1, s2) != 0) {
+            printf("\tRecord %d: fscanf() ret=%d %d %f '%s', my_mmscanf() ret=%d %d %f '%s'\n",
+                   records, ret1, i1, f1, s1, ret2, i2, f2, s2);
+            passed = 0;
+            break;
+        }
+        if (ret1 <= 0) break;
+        records++;
+    }
+    printf("\tRecords matched: %d\n", records);
+
+    fclose(fp);
+    my_mmap_close(mm);
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// test_fd_continuation: Two back-to-back my_fdscanf() calls on the same fd
+// must pick up exactly where the first one stopped.
+int test_fd_continuation(const char *name, const char *file, int exp_val1, int exp_val2) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+    printf("Input file: %s\n", file);
+
+    int fd = open(file, O_RDONLY);
+    if (fd < 0) { printf("FAIL: Can't open %s\n", file); tests_failed++; return 0; }
+
+    int v1 = -999, v2 = -999;
+    int ret1 = my_fdscanf(fd, "%d", &v1);
+    int ret2 = my_fdscanf(fd, "%d", &v2);
+    my_fdscanf_release(fd);
+    close(fd);
+
+    printf("\tmy_fdscanf() returned: %d %d, values: %d %d\n", ret1, ret2, v1, v2);
+    printf("\tExpected: ret=1 1, values: %d %d\n", exp_val1, exp_val2);
+    int passed = (ret1 == 1 && ret2 == 1 && v1 == exp_val1 && v2 == exp_val2);
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// test_fscanf_then_fgets: my_fscanf() must leave the stream exactly where
+// scanf() would, so stdio calls that follow see the unread remainder.
+int test_fscanf_then_fgets(const char *name, const char *file, const char *fmt) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+    printf("Input file: %s\n", file);
+    printf("Format: %s\n", fmt);
+
+    FILE *fp = fopen(file, "r");
+    if (!fp) { printf("FAIL: Can't open %s\n", file); tests_failed++; return 0; }
+    int v1 = -999;
+    char rest1[256] = {0};
+    int ret1 = fscanf(fp, fmt, &v1);
+    if (!fgets(rest1, sizeof(rest1), fp)) rest1[0] = '\0';
+    fclose(fp);
+
+    fp = fopen(file, "r");
+    int v2 = -999;
+    char rest2[256] = {0};
+    int ret2 = my_fscanf(fp, fmt, &v2);
+    if (!fgets(rest2, sizeof(rest2), fp)) rest2[0] = '\0';
+    fclose(fp);
+
+    printf("\tfscanf()    returned: %d, value: %d, rest: '%s'\n", ret1, v1, rest1);
+    printf("\tmy_fscanf() returned: %d, value: %d, rest: '%s'\n", ret2, v2, rest2);
+    int passed = (ret1 == ret2 && v1 == v2 && strcmp(rest1, rest2) == 0);
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// COMPILED FORMAT RUNNERS
+// test_compiled_records: Compiles the format once and runs it over every
+// record in the file with my_fdscanf_exec(). The results must match looping
+// the system fscanf() with the same format over the same file.
+int test_compiled_records(const char *name, const char *file, const char *fmt) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+    printf("Input file: %s\n", file);
+    printf("Format: %s\n", fmt);
+
+    FILE *fp = fopen(file, "r");
+    int fd = open(file, O_RDONLY);
+    my_scanf_program *prog = my_scanf_compile(fmt);
+    if (!fp || fd < 0 || !prog) {
+        printf("FAIL: Can't set up %s\n", file);
+        if (fp) fclose(fp);
+        if (fd >= 0) close(fd);
+        my_scanf_free(prog);
+        tests_failed++;
+        return 0;
+    }
+
+    int passed = 1;
+    int records = 0;
+    for (;;) {
+        int i1 = -999, i2 = -999;
+        float f1 = -999.0f, f2 = -999.0f;
+        char s1[256] = {0}, s2[256] = {0};
+        int ret1 = fscanf(fp, fmt, &i1, &f1, s1);
+        int ret2 = my_fdscanf_exec(fd, prog, &i2, &f2, s2);
+        if (ret1 != ret2 || i1 != i2 || f1 != f2 || strcmp(s1, s2) != 0) {
+            printf("\tRecord %d: fscanf() ret=%d %d %f '%s', my_fdscanf_exec() ret=%d %d %f '%s'\n",
+                   records, ret1, i1, f1, s1, ret2, i2, f2, s2);
+            passed = 0;
+            break;
+        }
+        if (ret1 <= 0) break;
+        records++;
+    }
+    printf("\tRecords matched: %d\n", records);
+
+    fclose(fp);
+    my_fdscanf_release(fd);
+    close(fd);
+    my_scanf_free(prog);
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// BULK COLUMN RUNNERS
+// test_columns: Scans up to max_records "%d,%lf %7s" records from the file
+// into int[], double[] and char[][8] columns with my_fdscan_columns(), and
+// checks every row against looping the system fscanf() over the same file.
+int test_columns(const char *name, const char *file, int max_records, int expected_records) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+    printf("Input file: %s\n", file);
+    printf("Format: %%d,%%lf %%7s (up to %d records)\n", max_records);
+
+    int ids[16];
+    double values[16];
+    char names[16][8];
+    void *cols[] = { ids, values, names };
+
+    int fd = open(file, O_RDONLY);
+    if (fd < 0) { printf("FAIL: Can't open %s\n", file); tests_failed++; return 0; }
+    int records = my_fdscan_columns(fd, "%d,%lf %7s", max_records, cols);
+    my_fdscanf_release(fd);
+    close(fd);
+
+    printf("\tmy_fdscan_columns() returned: %d (expected %d)\n", records, expected_records);
+    int passed = (records == expected_records);
+
+    FILE *fp = fopen(file, "r");
+    for (int i = 0; passed && fp && i < records; i++) {
+        int id = -999;
+        double value = -999.0;
+        char str[8] = {0};
+        fscanf(fp, "%d,%lf %7s", &id, &value, str);
+        printf("\trow %d: %d %g '%s' (fscanf: %d %g '%s')\n", i, ids[i], values[i], names[i], id, value, str);
+        if (id != ids[i] || value != values[i] || strcmp(str, names[i]) != 0) {
+            passed = 0;
+        }
+    }
+    if (fp) fclose(fp);
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// VIEW RUNNERS
+// test_view: Loads the file into memory and runs a format with a single %v
+// through my_sscanf() and my_mmscanf(). Both must return expected_ret and,
+// on success, a view equal to expected that points into their own input.
+// my_fdscanf() cannot hand out views, so it must report a matching failure.
+int test_view(const char *name, const char *file, const char *fmt, int expected_ret, const char *expected) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+    printf("Input file: %s\n", file);
+    printf("Format: %s\n", fmt);
+
+    FILE *fp = fopen(file, "r");
+    if (!fp) { printf("FAIL: Can't open %s\n", file); tests_failed++; return 0; }
+    char text[1024] = {0};
+    size_t n = fread(text, 1, sizeof(text) - 1, fp);
+    text[n] = '\0';
+    fclose(fp);
+
+    my_scanf_view v1 = { NULL, 0 }, v2 = { NULL, 0 }, v3 = { NULL, 0 };
+    int s_ret = my_sscanf(text, fmt, &v1);
+
+    my_scanf_mmap *mm = my_mmap_open(file, 0);
+    int mm_ret = mm ? my_mmscanf(mm, fmt, &v2) : -999;
+
+    int fd = open(file, O_RDONLY);
+    int fd_ret = my_fdscanf(fd, fmt, &v3);
+    my_fdscanf_release(fd);
+    close(fd);
+
+    printf("\tmy_sscanf()  returned: %d, view: '%.*s'\n", s_ret, (int)v1.len, v1.ptr ? v1.ptr : "");
+    printf("\tmy_mmscanf() returned: %d, view: '%.*s'\n", mm_ret, (int)v2.len, v2.ptr ? v2.ptr : "");
+    printf("\tmy_fdscanf() returned: %d\n", fd_ret);
+    printf("\tExpected: ret=%d, view: '%s'\n", expected_ret, expected);
+
+    int passed = (s_ret == expected_ret && mm_ret == expected_ret);
+    if (passed && expected_ret == 1) {
+        size_t len = strlen(expected);
+        passed = (v1.len == len && memcmp(v1.ptr, expected, len) == 0 &&
+                  v1.ptr >= text && v1.ptr + v1.len <= text + n &&
+                  v2.len == len && memcmp(v2.ptr, expected, len) == 0 &&
+                  fd_ret <= 0);
+    }
+    my_mmap_close(mm);
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// PARALLEL SCAN RUNNERS
+// test_columns_parallel: Writes a multi-megabyte "%d,%ld" file (one record per
+// line, with a bad line at bad_row unless it is negative and a blank line
+// after every blank_every-th record if that is positive), scans up to n rows
+// of it with my_scan_columns_parallel() on nthreads threads, and checks the
+// columns against a sequential my_fdscan_columns() over the same file.
+// Nothing may be written past row n. An n of 0 puts n exactly on the end of
+// the first chunk's lines (chunks are at least 1 MiB, and this file is small
+// enough on 4 threads that the first one is exactly that).
+#define PARALLEL_ROWS 300000
+#define PARALLEL_FIRST_CHUNK (1 << 20)
+int test_columns_parallel(const char *name, int nthreads, int bad_row, int blank_every, long n) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+
+    char path[] = "/tmp/my_scanf_parallel_XXXXXX";
+    int fd = mkstemp(path);
+    FILE *fp = (fd >= 0) ? fdopen(fd, "w") : NULL;
+    if (!fp) { printf("FAIL: Can't create %s\n", path); tests_failed++; return 0; }
+    for (int i = 0; i < PARALLEL_ROWS; i++) {
+        if (i == bad_row) fprintf(fp, "oops\n");
+        else fprintf(fp, "%d,%ld\n", i, -7L * i);
+        if (blank_every > 0 && i % blank_every == 0) fprintf(fp, "\n");
+    }
+    fclose(fp);
+    if (n == 0) {
+        fp = fopen(path, "r");
+        long pos = 0;
+        int c;
+        while (fp && (c = fgetc(fp)) != EOF) {
+            if (c == '\n' && (++n, pos >= PARALLEL_FIRST_CHUNK)) break;
+            pos++;
+        }
+        if (fp) fclose(fp);
+    }
+    printf("Format: %%d,%%ld (%d rows, %d threads, n = %ld)\n", PARALLEL_ROWS, nthreads, n);
+
+    int *ids = malloc(PARALLEL_ROWS * sizeof(int));
+    long *vals = malloc(PARALLEL_ROWS * sizeof(long));
+    int *seq_ids = malloc(PARALLEL_ROWS * sizeof(int));
+    long *seq_vals = malloc(PARALLEL_ROWS * sizeof(long));
+    void *cols[] = { ids, vals };
+    void *seq_cols[] = { seq_ids, seq_vals };
+
+    for (int i = 0; i < PARALLEL_ROWS; i++) ids[i] = -1;
+    long records = my_scan_columns_parallel(path, "%d,%ld", n, cols, nthreads);
+
+    fd = open(path, O_RDONLY);
+    int seq_records = my_fdscan_columns(fd, "%d,%ld", (int)n, seq_cols);
+    my_fdscanf_release(fd);
+    close(fd);
+    unlink(path);
+
+    printf("\tmy_scan_columns_parallel() returned: %ld, my_fdscan_columns(): %d\n", records, seq_records);
+    int passed = (records == seq_records);
+    for (long i = n; passed && i < PARALLEL_ROWS; i++) {
+        if (ids[i] != -1) {
+            printf("\trow %ld is past n but was written\n", i);
+            passed = 0;
+        }
+    }
+    for (long i = 0; passed && i < records; i++) {
+        if (ids[i] != seq_ids[i] || vals[i] != seq_vals[i]) {
+            printf("\trow %ld differs: %d %ld vs %d %ld\n", i, ids[i], vals[i], seq_ids[i], seq_vals[i]);
+            passed = 0;
+        }
+    }
+    free(ids); free(vals); free(seq_ids); free(seq_vals);
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// test_columns_parallel_views: my_scan_columns_parallel unmaps the file
+// before it returns, so it must refuse %v (and %mz) instead of handing back
+// dangling views; the same %v columns work through a caller-owned mapping.
+int test_columns_parallel_views(const char *name, const char *file) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+
+    my_scanf_view ids[8], words[8];
+    void *cols[] = { ids, words };
+    long refused = my_scan_columns_parallel(file, "%v %v", 8, cols, 2);
+    long refused_alloc = my_scan_columns_parallel(file, "%*v %mz", 8, cols, 2);
+
+    my_scanf_mmap *m = my_mmap_open(file, 0);
+    int rows = m ? my_mmscan_columns(m, "%v %v", 8, cols) : -1;
+    printf("\tparallel %%v: %ld, parallel %%mz: %ld, my_mmscan_columns %%v: %d rows\n",
+           refused, refused_alloc, rows);
+    int passed = refused == -1 && refused_alloc == -1 && rows > 0;
+    if (passed) {
+        printf("\tfirst row: '%.*s' '%.*s'\n", (int)ids[0].len, ids[0].ptr, (int)words[0].len, words[0].ptr);
+    }
+    my_mmap_close(m);
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// TEXT STREAM RUNNERS
+// test_cipher_stream: Writes a multi-megabyte file of text lines (some far
+// longer than %q's 256-byte limit), runs it through my_cipher_stream(), and
+// checks that the output is the same size, that its first line is what %q
+// gives for the same shift, and that streaming it back with the opposite
+// shift (and the same case inversion) restores the original byte for byte.
+#define CIPHER_STREAM_LINES 60000
+static char *read_whole_file(const char *path, size_t *len) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return NULL;
+    fseek(fp, 0, SEEK_END);
+    *len = (size_t)ftell(fp);
+    rewind(fp);
+    char *data = malloc(*len + 1);
+    if (data && fread(data, 1, *len, fp) != *len) { free(data); data = NULL; }
+    if (data) data[*len] = '\0';
+    fclose(fp);
+    return data;
+}
+
+int test_cipher_stream(const char *name, int offset, int invert_case) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+    printf("Shift: %s%d (%d lines)\n", invert_case ? "!" : "", offset, CIPHER_STREAM_LINES);
+
+    char paths[3][32];
+    int fds[3];
+    for (int k = 0; k < 3; k++) {
+        strcpy(paths[k], "/tmp/my_scanf_cipher_XXXXXX");
+        fds[k] = mkstemp(paths[k]);
+    }
+    FILE *fp = (fds[0] >= 0) ? fdopen(dup(fds[0]), "w") : NULL;
+    if (!fp || fds[1] < 0 || fds[2] < 0) { printf("FAIL: Can't create temp files\n"); tests_failed++; return 0; }
+    const char *words[] = { "Hello", "World!", "zebra", "QUIZ", "[edge]", "`tick`", "@home", "{brace}", "42" };
+    for (int i = 0; i < CIPHER_STREAM_LINES; i++) {
+        int nwords = (i % 97 == 96) ? 200 : 1 + i % 9;
+        for (int w = 0; w < nwords; w++) fprintf(fp, "%s ", words[(i + w) % 9]);
+        fprintf(fp, "line %d\n", i);
+    }
+    fclose(fp);
+    lseek(fds[0], 0, SEEK_SET);   // the dup shared the write offset
+
+    long long forward = my_cipher_stream(fds[0], fds[1], offset, invert_case);
+    lseek(fds[1], 0, SEEK_SET);
+    long long back = my_cipher_stream(fds[1], fds[2], 26 - offset, invert_case);
+
+    size_t orig_len = 0, ciph_len = 0, back_len = 0;
+    char *orig = read_whole_file(paths[0], &orig_len);
+    char *ciph = read_whole_file(paths[1], &ciph_len);
+    char *restored = read_whole_file(paths[2], &back_len);
+
+    char fmt[16], first[256] = {0};
+    sprintf(fmt, invert_case ? "%%!%dq" : "%%%dq", offset);
+    my_sscanf(orig, fmt, first);
+    const char *nl = strchr(ciph, '\n');
+
+    printf("\tbytes in: %zu, forward: %lld, back: %lld\n", orig_len, forward, back);
+    printf("\tfirst line: '%.*s'\n", nl ? (int)(nl - ciph) : 0, ciph);
+    printf("\tvia %%q:     '%s'\n", first);
+    int passed = forward == (long long)orig_len && back == (long long)orig_len &&
+                 ciph_len == orig_len && back_len == orig_len &&
+                 nl != NULL && strlen(first) == (size_t)(nl - ciph) &&
+                 memcmp(first, ciph, strlen(first)) == 0 &&
+                 memcmp(orig, restored, orig_len) == 0 &&
+                 (offset % 26 == 0 && !invert_case) == (memcmp(orig, ciph, orig_len) == 0);
+
+    free(orig); free(ciph); free(restored);
+    for (int k = 0; k < 3; k++) { close(fds[k]); unlink(paths[k]); }
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// test_genz_stream: Writes lines of every shape %z cares about (empty,
+// all whitespace, padded on both sides with every whitespace byte, a line
+// longer than the stream's 1 MiB buffer, a last line with no newline), runs
+// the file through my_genz_stream(), and checks the output against %z on
+// each short line, plus the newline, and against a hand-built answer for
+// the long one.
+#define GENZ_STREAM_LINES 40000
+int test_genz_stream(const char *name, my_genz_mode mode, const char *fmt) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+    printf("Format: %s (%d lines)\n", fmt, GENZ_STREAM_LINES);
+
+    char paths[2][32];
+    int fds[2];
+    for (int k = 0; k < 2; k++) {
+        strcpy(paths[k], "/tmp/my_scanf_genz_XXXXXX");
+        fds[k] = mkstemp(paths[k]);
+    }
+    FILE *fp = (fds[0] >= 0) ? fdopen(dup(fds[0]), "w") : NULL;
+    if (!fp || fds[1] < 0) { printf("FAIL: Can't create temp files\n"); tests_failed++; return 0; }
+
+    const char *shapes[] = { "", "   ", "no cap", "  \t bet\r", "\vslay  queen \f ",
+                             "x", "it's giving\t\t", " \r" };
+    size_t expected_cap = 4 * 1024 * 1024, expected_len = 0;
+    char *expected = malloc(expected_cap);
+    const char *suffix = (mode == MY_GENZ_HAHA) ? " haha!" : (mode == MY_GENZ_LOL_EXCLAIM) ? " lol!" : " lol";
+    int passed = 1;
+    for (int i = 0; i < GENZ_STREAM_LINES && passed; i++) {
+        char line[64], out[256];
+        if (i == GENZ_STREAM_LINES / 2) {
+            // 1.5 MiB of words with a padded end
+            fputs("  ", fp);
+            for (int w = 0; w < 150000; w++) fputs("ok bestie", fp);
+            fputs(" \t\n", fp);
+            for (int w = 0; w < 150000; w++) expected_len += (size_t)sprintf(expected + expected_len, "ok bestie");
+            expected_len += (size_t)sprintf(expected + expected_len, "%s\n", suffix);
+            continue;
+        }
+        snprintf(line, sizeof(line), "%s", shapes[i % 8]);
+        if (i % 8 == 2) snprintf(line, sizeof(line), "no cap %d", i);
+        int last = (i == GENZ_STREAM_LINES - 1);
+        fprintf(fp, last ? "%s" : "%s\n", line);
+        if (my_sscanf(line, fmt, out) != 1) {
+            printf("\tmy_sscanf(\"%s\") did not convert\n", line);
+            passed = 0;
+        }
+        expected_len += (size_t)sprintf(expected + expected_len, last ? "%s" : "%s\n", out);
+    }
+    fclose(fp);
+    lseek(fds[0], 0, SEEK_SET);   // the dup shared the write offset
+
+    long long written = my_genz_stream(fds[0], fds[1], mode);
+    size_t got_len = 0;
+    char *got = read_whole_file(paths[1], &got_len);
+
+    printf("\tmy_genz_stream() returned: %lld, expected %zu bytes\n", written, expected_len);
+    passed = passed && got != NULL && written == (long long)expected_len && got_len == expected_len &&
+             memcmp(got, expected, expected_len) == 0;
+    if (!passed && got != NULL) {
+        size_t k = 0;
+        while (k < got_len && k < expected_len && got[k] == expected[k]) k++;
+        printf("\tfirst difference at byte %zu: '%.20s' vs '%.20s'\n", k, got + k, expected + k);
+    }
+    passed = passed && my_genz_stream(fds[0], fds[1], (my_genz_mode)7) == -1;
+
+    free(got); free(expected);
+    for (int k = 0; k < 2; k++) { close(fds[k]); unlink(paths[k]); }
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// LINE ALLOCATION RUNNERS
+// test_line_alloc: Reads every line of file with an allocating line
+// conversion (fmt is "%mz", "%!3mq", ...; "%*c" after it takes the newline)
+// through my_sscanf on each line, my_fdscanf and my_scanf, and checks each
+// string against a hand-built answer: nothing is cut short, whatever the
+// length of the line, and no bytes are left for the next line.
+// size is the destination array (0 = allocated, no limit)
+static void manual_line(const char *fmt, const char *line, char *out, size_t size) {
+    int invert = strchr(fmt, '!') != NULL;
+    if (strchr(fmt, 'q')) {
+        int offset = atoi(fmt + strcspn(fmt, "0123456789"));
+        size_t k = 0;
+        for (; line[k] && (size == 0 || k < size - 1); k++) {
+            int c = (unsigned char)line[k];
+            if (c >= 'a' && c <= 'z') c = (invert ? 'A' : 'a') + (c - 'a' + offset) % 26;
+            else if (c >= 'A' && c <= 'Z') c = (invert ? 'a' : 'A') + (c - 'A' + offset) % 26;
+            out[k] = (char)c;
+        }
+        out[k] = '\0';
+        return;
+    }
+    const char *suffix = !invert ? " lol" : strchr(fmt, 'h') ? " haha!" : " lol!";
+    size_t start = strspn(line, " \t\v\f\r"), end = strlen(line);
+    if (size > 0 && end - start > size - strlen(suffix) - 1) end = start + size - strlen(suffix) - 1;
+    while (end > start && strchr(" \t\v\f\r", line[end - 1])) end--;
+    if (end == start) suffix++;
+    sprintf(out, "%.*s%s", (int)(end - start), line + start, suffix);
+}
+
+int test_line_alloc(const char *name, const char *file, const char *fmt) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+    printf("Format: %s%%*c\n", fmt);
+
+    size_t len = 0;
+    char *text = read_whole_file(file, &len);
+    if (!text) { printf("FAIL: Can't open %s\n", file); tests_failed++; return 0; }
+    char *lines[16];
+    int nlines = 0;
+    for (char *p = text; *p && nlines < 16; nlines++) {
+        lines[nlines] = p;
+        p = strchr(p, '\n');
+        *p++ = '\0';
+    }
+
+    char with_newline[32];
+    snprintf(with_newline, sizeof(with_newline), "%s%%*c", fmt);
+    char *expected = malloc(len + 64);
+    int passed = 1;
+    const char *front[] = { "my_sscanf", "my_fdscanf", "my_scanf" };
+    for (int f = 0; f < 3 && passed; f++) {
+        int fd = open(file, O_RDONLY);
+        if (f == 2) stdin = freopen(file, "r", stdin);
+        size_t longest = 0;
+        for (int i = 0; i < nlines && passed; i++) {
+            char *got = NULL;
+            int ret = (f == 0) ? my_sscanf(lines[i], fmt, &got)
+                    : (f == 1) ? my_fdscanf(fd, with_newline, &got)
+                    : my_scanf(with_newline, &got);
+            manual_line(fmt, lines[i], expected, 0);
+            if (ret != 1 || got == NULL || strcmp(got, expected) != 0) {
+                printf("\t%s line %d: ret=%d, got %zu bytes, expected %zu\n", front[f], i + 1, ret,
+                       got ? strlen(got) : 0, strlen(expected));
+                passed = 0;
+            } else if (strlen(got) > longest) {
+                longest = strlen(got);
+            }
+            free(got);
+        }
+        my_fdscanf_release(fd);
+        close(fd);
+        if (passed) printf("\t%-10s %d lines, longest string %zu bytes\n", front[f], nlines, longest);
+    }
+    free(expected);
+    free(text);
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// test_line_cap: Reads lines of 250-300 characters into a 256-byte array
+// through my_scanf (stdin) and my_fscanf (FILE*), whose windows are refilled
+// a byte at a time, and through my_sscanf. Each must be cut exactly where
+// the array ends ("%*z%*c" then drops the rest of the line).
+int test_line_cap(const char *name, const char *file, const char *fmt) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+    printf("Format: %s%%*z%%*c into char[256]\n", fmt);
+
+    size_t len = 0;
+    char *text = read_whole_file(file, &len);
+    if (!text) { printf("FAIL: Can't open %s\n", file); tests_failed++; return 0; }
+    char *lines[32];
+    int nlines = 0;
+    for (char *p = text; *p && nlines < 32; nlines++) {
+        lines[nlines] = p;
+        p = strchr(p, '\n');
+        *p++ = '\0';
+    }
+
+    char full[32];
+    snprintf(full, sizeof(full), "%s%%*z%%*c", fmt);
+    const char *front[] = { "my_sscanf", "my_fscanf", "my_scanf" };
+    int passed = 1;
+    for (int f = 0; f < 3 && passed; f++) {
+        FILE *fp = (f == 1) ? fopen(file, "r") : NULL;
+        if (f == 2) stdin = freopen(file, "r", stdin);
+        for (int i = 0; i < nlines && passed; i++) {
+            char got[256 + 16], expected[256];
+            memset(got, '#', sizeof(got));
+            int ret = (f == 0) ? my_sscanf(lines[i], fmt, got)
+                    : (f == 1) ? my_fscanf(fp, full, got)
+                    : my_scanf(full, got);
+            manual_line(fmt, lines[i], expected, 256);
+            if (ret != 1 || strcmp(got, expected) != 0 || got[256] != '#') {
+                printf("\t%s line %d (%zu chars): ret=%d, got %zu chars, expected %zu\n", front[f], i + 1,
+                       strlen(lines[i]), ret, strnlen(got, sizeof(got)), strlen(expected));
+                passed = 0;
+            }
+        }
+        if (fp) fclose(fp);
+        if (passed) printf("\t%-10s %d lines cut correctly\n", front[f], nlines);
+    }
+    free(text);
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// test_line_alloc_limits: The edges of 'm' and of unbounded line reads. A
+// width still caps %mz the way it caps %z, suppressed %*z / %*q skip a whole
+// long line, %m on other conversions is ignored like any unknown specifier,
+// my_scan_columns frees the strings of a record it does not count, and the
+// entry points that re-run or discard conversions refuse 'm' formats.
+int test_line_alloc_limits(const char *name, const char *file) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+
+    size_t len = 0;
+    char *text = read_whole_file(file, &len);
+    if (!text) { printf("FAIL: Can't open %s\n", file); tests_failed++; return 0; }
+    int passed = 1;
+
+    char fixed[16] = {0}, *alloc = NULL;
+    int r1 = my_sscanf(text, "%10z", fixed);
+    int r2 = my_sscanf(text, "%10mz", &alloc);
+    printf("\t%%10z: '%s', %%10mz: '%s'\n", fixed, alloc ? alloc : "(null)");
+    passed = passed && r1 == 1 && r2 == 1 && alloc && strcmp(fixed, alloc) == 0;
+    free(alloc);
+
+    // The first line is over 6 KB; the default %z buffer holds 256
+    char word[16] = {0};
+    int r3 = my_sscanf(text, "%*z %s", word);
+    int r4 = my_sscanf(text, "%*q%*c%s", word + 8);
+    printf("\tafter %%*z: '%s', after %%*q: '%s'\n", word, word + 8);
+    passed = passed && r3 == 1 && r4 == 1 && strcmp(word, "Next") == 0 && strcmp(word + 8, "Next") == 0;
+
+    int value = 0;
+    passed = passed && my_sscanf("42", "%md", &value) == 0 && value == 0;
+
+    char *col[4] = {0};
+    void *cols[] = { col };
+    int rows = my_sscan_columns("no cap\nbet", "%mz%*c", 4, cols);
+    // The second record stops at EOF before its newline, so its string is freed
+    printf("\tmy_sscan_columns(%%mz%%*c): %d rows, '%s'\n", rows, col[0] ? col[0] : "");
+    passed = passed && rows == 1 && col[0] && strcmp(col[0], "no cap lol") == 0;
+    free(col[0]);
+
+    const char *formats[] = { "%d", "%mq" };
+    void *dests[] = { &value };
+    passed = passed && my_parser_open("%mz", dests) == NULL && my_scanf_set_compile(formats, 2) == NULL &&
+             my_scan_columns_parallel(file, "%mz%*c", 4, cols, 2) == -1;
+    printf("\tparser, set and parallel scan refuse %%m: %s\n", passed ? "yes" : "no");
+    free(text);
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// INSTRUMENTATION RUNNERS
+// test_stats: Runs a few my_sscanf() calls with known outcomes and checks the
+// counters they leave behind. In a normal build (no MY_SCANF_STATS) the
+// counters must stay at zero; `make test-stats` builds the suite with them on.
+int test_stats(const char *name) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+
+    int i = -999, j = -999;
+    double d = -999.0;
+    char str[256] = {0};
+    my_scanf_stats st;
+
+    my_scanf_stats_reset();
+    int ret1 = my_sscanf("  42 3.5 hi", "%d %lf %s", &i, &d, str);
+    int ret2 = my_sscanf("7;8", "%d,%d", &i, &j);
+    int ret3 = my_sscanf("abc", "%d", &i);
+    int ret4 = my_sscanf("1.00000000000000000000001", "%lf", &d);
+    my_scanf_stats_get(&st);
+
+    // A scanner of its own charges its own counters, not the thread's
+    my_scanf_stats sc_st, after;
+    my_scanner_t *sc = my_scanner_open_string("5 6");
+    int ret5 = my_scanner_scanf(sc, "%d %d", &i, &j);
+    my_scanner_stats_get(sc, &sc_st);
+    my_scanner_close(sc);
+    my_scanf_stats_get(&after);
+
+    const my_scanf_reader_stats *ints = &st.readers[MY_SCANF_READ_INTEGER];
+    const my_scanf_reader_stats *dbls = &st.readers[MY_SCANF_READ_DOUBLE];
+    printf("\tmy_sscanf() returned: %d %d %d %d, my_scanner_scanf(): %d\n", ret1, ret2, ret3, ret4, ret5);
+    printf("\tscanner: scans=%llu bytes=%llu\n", sc_st.scans, sc_st.bytes_consumed);
+    printf("\tscans=%llu bytes=%llu whitespace=%llu literal_mismatches=%llu float_slow_paths=%llu\n",
+           st.scans, st.bytes_consumed, st.whitespace_skipped, st.literal_mismatches, st.float_slow_paths);
+    printf("\t%s: calls=%llu matching_failures=%llu input_failures=%llu\n",
+           my_scanf_stats_reader_name(MY_SCANF_READ_INTEGER), ints->calls, ints->matching_failures, ints->input_failures);
+    printf("\t%s: calls=%llu\n", my_scanf_stats_reader_name(MY_SCANF_READ_DOUBLE), dbls->calls);
+
+#ifdef MY_SCANF_STATS
+    // "  42 3.5 hi" is consumed whole (11 bytes, 4 of them whitespace), "7;8"
+    // stops in front of ';' (1 byte), "abc" consumes nothing and the long
+    // double literal (25 bytes) needs strtod()
+    int passed = (st.scans == 4 && st.bytes_consumed == 11 + 1 + 0 + 25 &&
+                  st.whitespace_skipped == 4 && st.literal_mismatches == 1 &&
+                  st.float_slow_paths == 1 && ints->calls == 3 &&
+                  ints->matching_failures == 1 && ints->input_failures == 0 &&
+                  dbls->calls == 2 && dbls->cycles > 0 &&
+                  st.readers[MY_SCANF_READ_STRING].calls == 1 &&
+                  sc_st.scans == 1 && sc_st.readers[MY_SCANF_READ_INTEGER].calls == 2 &&
+                  sc_st.bytes_consumed == 3 && after.scans == st.scans);
+#else
+    my_scanf_stats zero;
+    memset(&zero, 0, sizeof(zero));
+    int passed = (memcmp(&st, &zero, sizeof(st)) == 0 && memcmp(&sc_st, &zero, sizeof(sc_st)) == 0 &&
+                  memcmp(&after, &zero, sizeof(after)) == 0);
+#endif
+    passed = passed && ret1 == 3 && ret2 == 1 && ret3 == 0 && ret4 == 1 && ret5 == 2;
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// SCANNER CONTEXT RUNNERS
+// test_scanner_records: Opens one scanner per source kind (string, fd, FILE*
+// and mapped path) on the same file and loops the format over every record
+// with my_scanner_scanf(). Each must match looping the system fscanf().
+int test_scanner_records(const char *name, const char *file, const char *fmt) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+    printf("Input file: %s\n", file);
+    printf("Format: %s\n", fmt);
+
+    FILE *fp = fopen(file, "r");
+    if (!fp) { printf("FAIL: Can't open %s\n", file); tests_failed++; return 0; }
+    char text[1024] = {0};
+    size_t n = fread(text, 1, sizeof(text) - 1, fp);
+    text[n] = '\0';
+    fclose(fp);
+
+    const char *kinds[6] = { "string", "fd", "FILE*", "path", "uring", "thread" };
+    int passed = 1;
+    for (int k = 0; k < 6 && passed; k++) {
+        FILE *ref = fopen(file, "r");
+        FILE *stream = NULL;
+        int fd = -1;
+        my_scanner_t *sc = NULL;
+        switch (k) {
+            case 0: sc = my_scanner_open_string(text); break;
+            case 1: fd = open(file, O_RDONLY); sc = my_scanner_open_fd(fd, 16); break;
+            case 2: stream = fopen(file, "r"); sc = my_scanner_open_file(stream); break;
+            case 3: sc = my_scanner_open_path(file, 0); break;
+            case 4: fd = open(file, O_RDONLY); sc = my_scanner_open_uring(fd, 2, 16); break;
+            case 5: fd = open(file, O_RDONLY); sc = my_scanner_open_pipeline(fd, 2, 16); break;
+        }
+        if (!ref || !sc) { printf("\tCan't open a %s scanner\n", kinds[k]); passed = 0; }
+
+        int records = 0;
+        while (passed) {
+            int i1 = -999, i2 = -999;
+            float f1 = -999.0f, f2 = -999.0f;
+            char s1[256] = {0}, s2[256] = {0};
+            int ret1 = fscanf(ref, fmt, &i1, &f1, s1);
+            int ret2 = my_scanner_scanf(sc, fmt, &i2, &f2, s2);
+            if (ret1 != ret2 || i1 != i2 || f1 != f2 || strcmp(s1, s2) != 0) {
+                printf("\t%s record %d: fscanf() ret=%d %d %f '%s', my_scanner_scanf() ret=%d %d %f '%s'\n",
+                       kinds[k], records, ret1, i1, f1, s1, ret2, i2, f2, s2);
+                passed = 0;
+            }
+            if (ret1 <= 0) break;
+            records++;
+        }
+        printf("\t%-6s scanner: %d records matched\n", kinds[k], records);
+
+        my_scanner_close(sc);
+        if (ref) fclose(ref);
+        if (stream) fclose(stream);
+        if (fd >= 0) close(fd);
+    }
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// test_scanner_checkpoint: Reads lines of mixed shapes by trying one format
+// after another between a checkpoint and a rollback, on every scanner kind
+// (small buffers, so a rollback has to reach back across refills). Every
+// record must be read by exactly the right format, and the line after the
+// last record must still be there once the failed tries are rolled back.
+int test_scanner_checkpoint(const char *name, const char *file) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+    printf("Input file: %s\n", file);
+
+    FILE *fp = fopen(file, "r");
+    if (!fp) { printf("FAIL: Can't open %s\n", file); tests_failed++; return 0; }
+    char text[1024] = {0};
+    size_t n = fread(text, 1, sizeof(text) - 1, fp);
+    text[n] = '\0';
+    fclose(fp);
+
+    const char *kinds[6] = { "string", "fd", "FILE*", "path", "uring", "thread" };
+    int passed = 1;
+    for (int k = 0; k < 6 && passed; k++) {
+        FILE *stream = NULL;
+        int fd = -1;
+        my_scanner_t *sc = NULL;
+        switch (k) {
+            case 0: sc = my_scanner_open_string(text); break;
+            case 1: fd = open(file, O_RDONLY); sc = my_scanner_open_fd(fd, 16); break;
+            case 2: stream = fopen(file, "r"); sc = my_scanner_open_file(stream); break;
+            case 3: sc = my_scanner_open_path(file, 0); break;
+            case 4: fd = open(file, O_RDONLY); sc = my_scanner_open_uring(fd, 2, 16); break;
+            case 5: fd = open(file, O_RDONLY); sc = my_scanner_open_pipeline(fd, 2, 16); break;
+        }
+        if (!sc) { printf("\tCan't open a %s scanner\n", kinds[k]); passed = 0; break; }
+
+        int gets = 0, status_sum = 0, id_users = 0, named_users = 0, temps = 0;
+        float temp_sum = 0.0f;
+        char path[64] = {0}, user[64] = {0}, unit[8] = {0};
+        int a = 0, b = 0;
+        float t = 0.0f;
+        for (;;) {
+            my_scanner_scanf(sc, " ");
+            my_scanner_checkpoint(sc);
+            if (my_scanner_scanf(sc, "GET %63s %d", path, &a) == 2) {
+                gets++;
+                status_sum += a;
+            } else if ((my_scanner_rollback(sc), my_scanner_scanf(sc, "user %d %d", &a, &b)) == 2) {
+                id_users++;
+                passed = passed && a == 42 && b == 9;
+            } else if ((my_scanner_rollback(sc), my_scanner_scanf(sc, "user %63s %d", user, &b)) == 2) {
+                named_users++;
+                passed = passed && strcmp(user, "a_much_longer_user_name_than_the_buffer") == 0 && b == 7;
+            } else if ((my_scanner_rollback(sc), my_scanner_scanf(sc, "temp %f %7s", &t, unit)) == 2) {
+                temps++;
+                temp_sum += t;
+            } else {
+                my_scanner_rollback(sc);
+                my_scanner_commit(sc);
+                break;
+            }
+            my_scanner_commit(sc);
+        }
+
+        // The line no format matched is untouched
+        char rest[64] = {0};
+        int ret = my_scanner_scanf(sc, "%63s", rest);
+        passed = passed && ret == 1 && strcmp(rest, "trailer") == 0;
+        if (stream) {
+            char line[64] = {0};
+            passed = passed && fgets(line, sizeof(line), stream) != NULL && strcmp(line, " line\n") == 0;
+        }
+        passed = passed && gets == 2 && status_sum == 604 && id_users == 1 && named_users == 1 &&
+                 temps == 2 && temp_sum == 18.25f;
+        printf("\t%-6s scanner: %d GET, %d+%d user, %d temp, then '%s'\n",
+               kinds[k], gets, id_users, named_users, temps, rest);
+
+        my_scanner_close(sc);
+        if (stream) fclose(stream);
+        if (fd >= 0) close(fd);
+    }
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// test_scanner_threads: nthreads threads each scan their own generated input
+// ("i i*3" lines) through a private scanner at the same time; every thread
+// must read back exactly the values it was given.
+#define SCANNER_THREAD_RECORDS 20000
+typedef struct {
+    int id;
+    int ok;
+} ScannerThreadJob;
+
+static void *scanner_thread(void *arg) {
+    ScannerThreadJob *job = arg;
+    char *text = malloc(SCANNER_THREAD_RECORDS * 24);
+    size_t len = 0;
+    for (int i = 0; i < SCANNER_THREAD_RECORDS; i++) {
+        len += (size_t)sprintf(text + len, "%d %d\n", i + job->id, (i + job->id) * 3);
+    }
+
+    my_scanner_t *sc = my_scanner_open_memory(text, len);
+    job->ok = (sc != NULL);
+    for (int i = 0; job->ok && i < SCANNER_THREAD_RECORDS; i++) {
+        int a = -1, b = -1;
+        job->ok = (my_scanner_scanf(sc, "%d %d", &a, &b) == 2 && a == i + job->id && b == a * 3);
+    }
+    int extra;
+    if (job->ok) job->ok = (my_scanner_scanf(sc, "%d", &extra) == -1);
+    my_scanner_close(sc);
+    free(text);
+    return NULL;
+}
+
+int test_scanner_threads(const char *name, int nthreads) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+    printf("Threads: %d, records per thread: %d\n", nthreads, SCANNER_THREAD_RECORDS);
+
+    pthread_t threads[16];
+    ScannerThreadJob jobs[16];
+    for (int t = 0; t < nthreads; t++) {
+        jobs[t].id = t * 1000000;
+        jobs[t].ok = 0;
+        pthread_create(&threads[t], NULL, scanner_thread, &jobs[t]);
+    }
+    int passed = 1;
+    for (int t = 0; t < nthreads; t++) {
+        pthread_join(threads[t], NULL);
+        printf("\tthread %d: %s\n", t, jobs[t].ok ? "all records matched" : "mismatch");
+        passed = passed && jobs[t].ok;
+    }
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// test_fdscanf_threads: nthreads threads open, scan and release descriptors
+// at the same time. The descriptors are spread over a wide range, so the
+// shared my_fdscanf table keeps growing under them; every thread must still
+// read the file's records back exactly.
+#define FDSCANF_THREAD_ROUNDS 300
+static void *fdscanf_thread(void *arg) {
+    ScannerThreadJob *job = arg;
+    job->ok = 1;
+    for (int r = 0; job->ok && r < FDSCANF_THREAD_ROUNDS; r++) {
+        int raw = open("test_inputs/test_compiled_records.txt", O_RDONLY);
+        int fd = (raw >= 0) ? fcntl(raw, F_DUPFD, 64 + (r * 7 + job->id) % 960) : -1;
+        if (raw >= 0) close(raw);
+        if (fd < 0) { job->ok = 0; break; }
+        int ids = 0, records = 0, id;
+        float f;
+        char word[32];
+        while (my_fdscanf(fd, "%d,%f %31s", &id, &f, word) == 3) {
+            ids += id;
+            records++;
+        }
+        job->ok = (records == 4 && ids == 1 + 22 + 333 + 4444);
+        my_fdscanf_release(fd);
+        close(fd);
+    }
+    return NULL;
+}
+
+int test_fdscanf_threads(const char *name, int nthreads) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+    printf("Threads: %d, descriptors per thread: %d\n", nthreads, FDSCANF_THREAD_ROUNDS);
+
+    pthread_t threads[16];
+    ScannerThreadJob jobs[16];
+    for (int t = 0; t < nthreads; t++) {
+        jobs[t].id = t;
+        jobs[t].ok = 0;
+        pthread_create(&threads[t], NULL, fdscanf_thread, &jobs[t]);
+    }
+    int passed = 1;
+    for (int t = 0; t < nthreads; t++) {
+        pthread_join(threads[t], NULL);
+        printf("\tthread %d: %s\n", t, jobs[t].ok ? "all records matched" : "mismatch");
+        passed = passed && jobs[t].ok;
+    }
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// SIMD KERNEL RUNNERS
+// test_kernels: Scans generated inputs (whitespace runs of every length up to
+// 70, digit runs up to 40, %llx runs up to 20, %llb runs up to 70 and %q
+// lines up to 70 at every offset, so every vector width sees full blocks and tails) once per kernel set this CPU can run. Every set must
+// give exactly what the scalar set gives.
+#define KERNEL_CASES 71
+
+typedef struct {
+    int ret;
+    long long value;
+    long long hex;
+    long long bits;
+    float f;
+    char str[128];
+    char cipher[80];
+} KernelResult;
+
+static void run_kernel_cases(KernelResult *out) {
+    static const char ws[] = " \t\n\v\f\r";
+    const char *digits = "9876543210123456789098765432101234567890";
+    const char *hex = "DeadBeef0123456789aBcDeF";
+    const char *bits = "1101001110001011110101100100111010001101111000010110100111010011100101";
+    for (int c = 0; c < KERNEL_CASES; c++) {
+        char text[256];
+        size_t len = 0;
+        for (int k = 0; k < c; k++) text[len++] = ws[k % 6];
+        len += (size_t)sprintf(text + len, "%.*s %.*s %.*s", 1 + c % 40, digits,
+                               1 + c % 20, hex, 1 + c % 7, "1.25e-3x");
+        KernelResult *r = &out[c];
+        memset(r, 0, sizeof(*r));
+        r->ret = my_sscanf(text, "%lld %llx %f %s", &r->value, &r->hex, &r->f, r->str);
+        // %f keeps a newline in front of it, so this only reads when the
+        // whitespace run has none
+        float g = 0.0f;
+        r->ret = r->ret * 10 + my_sscanf(text + (c % 3 ? 0 : c / 2), "%f", &g);
+        r->f += g;
+        sprintf(text, "%s%.*s%s", c % 3 ? "" : "0b", 1 + c % 70, bits, c % 2 ? " 1" : "2");
+        r->ret = r->ret * 10 + my_sscanf(text, "%llb", &r->bits);
+        // Letters next to the range edges ('@', '[', '`', '{') and high bytes
+        // must pass through the SIMD shift untouched
+        char line[80], fmt[16];
+        for (int k = 0; k < c; k++) line[k] = "Za@[`{zA\xc1m\xfaQ. y"[(k * 7 + c) % 14];
+        sprintf(line + c, "\nrest");
+        sprintf(fmt, c % 2 ? "%%!%dq" : "%%%dq", c % 26);
+        r->ret = r->ret * 10 + my_sscanf(line, fmt, r->cipher);
+    }
+}
+
+int test_kernels(const char *name) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+
+    static KernelResult expected[KERNEL_CASES], got[KERNEL_CASES];
+    const char *names[] = { "scalar", "sse2", "sse4.2", "avx2", "avx512bw" };
+    int passed = (my_scanf_use_kernels("scalar") == 0);
+    run_kernel_cases(expected);
+
+    for (size_t k = 1; k < sizeof(names) / sizeof(names[0]) && passed; k++) {
+        if (my_scanf_use_kernels(names[k]) != 0) {
+            printf("\t%-8s not supported here\n", names[k]);
+            continue;
+        }
+        run_kernel_cases(got);
+        int bad = -1;
+        for (int c = 0; c < KERNEL_CASES && bad < 0; c++) {
+            if (memcmp(&expected[c], &got[c], sizeof(KernelResult)) != 0) bad = c;
+        }
+        if (bad >= 0) {
+            printf("\t%-8s case %d: ret=%d %lld %llx '%s', scalar ret=%d %lld %llx '%s'\n", names[k], bad,
+                   got[bad].ret, got[bad].value, got[bad].hex, got[bad].str,
+                   expected[bad].ret, expected[bad].value, expected[bad].hex, expected[bad].str);
+            passed = 0;
+        } else {
+            printf("\t%-8s matches scalar on %d cases\n", names[k], KERNEL_CASES);
+        }
+    }
+    // Back to what the library picked at load time
+    passed = passed && my_scanf_use_kernels(NULL) == 0 && my_scanf_use_kernels("no-such-set") == -1;
+    printf("\tactive set: %s\n", my_scanf_kernels());
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// PUSH PARSER RUNNERS
+// test_parser_records: Pushes the file into a my_scanf_parser chunk bytes at
+// a time (so tokens are split across feeds at every possible point for small
+// chunks) and collects each record it reports. The records must equal what
+// a scanner looping the same format over the whole file reads.
+int test_parser_records(const char *name, const char *file, const char *fmt, size_t chunk) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+    printf("Input file: %s\n", file);
+    printf("Format: %s, chunk: %zu bytes\n", fmt, chunk);
+
+    FILE *fp = fopen(file, "r");
+    if (!fp) { printf("FAIL: Can't open %s\n", file); tests_failed++; return 0; }
+    char text[1024] = {0};
+    size_t n = fread(text, 1, sizeof(text) - 1, fp);
+    fclose(fp);
+
+    int i = -999;
+    float f = -999.0f;
+    char str[256] = {0};
+    void *dests[3] = { &i, &f, str };
+    my_scanf_parser *parser = my_parser_open(fmt, dests);
+    my_scanner_t *sc = my_scanner_open_memory(text, n);
+    int passed = (parser != NULL && sc != NULL);
+
+    int records = 0;
+    int status = MY_PARSE_NEED_MORE;
+    size_t pos = 0;
+    while (passed && status != MY_PARSE_END) {
+        if (status == MY_PARSE_NEED_MORE && pos < n) {
+            size_t len = (n - pos < chunk) ? n - pos : chunk;
+            status = my_parser_feed(parser, text + pos, len);
+            pos += len;
+        } else if (status == MY_PARSE_NEED_MORE) {
+            status = my_parser_finish(parser);
+        } else {
+            status = my_parser_feed(parser, NULL, 0);
+        }
+        if (status != MY_PARSE_RECORD && status != MY_PARSE_ERROR) {
+            continue;
+        }
+
+        int i2 = -999;
+        float f2 = -999.0f;
+        char str2[256] = {0};
+        int ret = my_scanner_scanf(sc, fmt, &i2, &f2, str2);
+        if ((status == MY_PARSE_RECORD) != (ret == 3) ||
+            (status == MY_PARSE_RECORD && (i != i2 || f != f2 || strcmp(str, str2) != 0))) {
+            printf("\trecord %d: parser status=%d %d %f '%s', my_scanner_scanf() ret=%d %d %f '%s'\n",
+                   records, status, i, f, str, ret, i2, f2, str2);
+            passed = 0;
+        }
+        // The scanner stops for good at a bad record; the parser skips its line
+        if (status == MY_PARSE_ERROR) break;
+        records++;
+        status = MY_PARSE_RECORD;
+    }
+    printf("\t%d records matched\n", records);
+
+    my_parser_close(parser);
+    my_scanner_close(sc);
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// test_parser_resync: One byte per feed through a stream with a bad line in
+// the middle and no newline after the last record. Expects the first record,
+// an error for the bad line, the next record once its line is complete, and
+// the last one only at my_parser_finish.
+int test_parser_resync(const char *name) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+
+    const char *text = "10 -3.25\nten 4.5\n20 6.125\n30 1e2";
+    int i = -999;
+    double d = -999.0;
+    void *dests[2] = { &i, &d };
+    my_scanf_parser *parser = my_parser_open("%d %lf", dests);
+
+    char seen[64] = {0};
+    int sum = 0;
+    double dsum = 0.0;
+    size_t k = 0;
+    for (const char *c = text; *c != '\0'; c++) {
+        for (int status = my_parser_feed(parser, c, 1); status != MY_PARSE_NEED_MORE;
+             status = my_parser_feed(parser, NULL, 0)) {
+            seen[k++] = (status == MY_PARSE_RECORD) ? 'R' : 'E';
+            if (status == MY_PARSE_RECORD) { sum += i; dsum += d; }
+        }
+        if (c[1] == '\0') seen[k++] = '|';
+    }
+    for (int status = my_parser_finish(parser); status != MY_PARSE_END;
+         status = my_parser_feed(parser, NULL, 0)) {
+        seen[k++] = (status == MY_PARSE_RECORD) ? 'R' : (status == MY_PARSE_ERROR) ? 'E' : '?';
+        if (status == MY_PARSE_RECORD) { sum += i; dsum += d; }
+    }
+    my_parser_close(parser);
+
+    printf("\tstatuses: %s (| = end of input), int sum %d, double sum %g\n", seen, sum, dsum);
+    int passed = (strcmp(seen, "RER|R") == 0 && sum == 60 && dsum == -3.25 + 6.125 + 100.0);
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// MULTI-FORMAT RUNNERS
+// test_scanf_any: Reads a file of mixed log lines with my_scanner_any_exec on
+// every scanner kind. Formats overlap on purpose: some share a prefix and
+// split at a literal ("logged in" / "logged out"), some at a conversion
+// (%d / %s), and one is a prefix of another, so a shared conversion's value
+// has to reach the format that wins. Each line must report the first format
+// that matches it, with that format's values.
+int test_scanf_any(const char *name, const char *file) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+    printf("Input file: %s\n", file);
+
+    const char *formats[] = {
+        "GET %63s %d",
+        "POST %63s %d %d",
+        "user %d logged in from %63s",
+        "user %63s logged in from %63s",
+        "user %d logged out after %d",
+        "temp %f %7s",
+        "temp %d %7s",
+        "kernel: %z",
+        "POST %63s %d",
+    };
+    const char *expected[] = {
+        "0 /index 200", "1 /form 201 512", "2 42 10.0.0.1", "3 bob 10.0.0.2", "4 42 360",
+        "5 21.5 C", "5 -3 F", "7 oom killer invoked lol", "8 /short 204",
+        "none", "none", "none", "none", "0 /last 404", "eof",
+    };
+    int num_expected = (int)(sizeof(expected) / sizeof(expected[0]));
+
+    char path[9][64], word[9][64], z[256];
+    int a[9], b[9];
+    float t = 0.0f;
+    void *d0[] = { path[0], &a[0] };
+    void *d1[] = { path[1], &a[1], &b[1] };
+    void *d2[] = { &a[2], word[2] };
+    void *d3[] = { path[3], word[3] };
+    void *d4[] = { &a[4], &b[4] };
+    void *d5[] = { &t, word[5] };
+    void *d6[] = { &a[6], word[6] };
+    void *d7[] = { z };
+    void *d8[] = { path[8], &a[8] };
+    void **dests[] = { d0, d1, d2, d3, d4, d5, d6, d7, d8 };
+
+    my_scanf_set *set = my_scanf_set_compile(formats, 9);
+    FILE *fp = fopen(file, "r");
+    if (!set || !fp) { printf("FAIL: Can't set up the test\n"); tests_failed++; return 0; }
+    char text[1024] = {0};
+    size_t n = fread(text, 1, sizeof(text) - 1, fp);
+    text[n] = '\0';
+    fclose(fp);
+
+    const char *kinds[6] = { "string", "fd", "FILE*", "path", "uring", "thread" };
+    int passed = 1;
+    for (int k = 0; k < 6 && passed; k++) {
+        FILE *stream = NULL;
+        int fd = -1;
+        my_scanner_t *sc = NULL;
+        switch (k) {
+            case 0: sc = my_scanner_open_string(text); break;
+            case 1: fd = open(file, O_RDONLY); sc = my_scanner_open_fd(fd, 16); break;
+            case 2: stream = fopen(file, "r"); sc = my_scanner_open_file(stream); break;
+            case 3: sc = my_scanner_open_path(file, 0); break;
+            case 4: fd = open(file, O_RDONLY); sc = my_scanner_open_uring(fd, 2, 16); break;
+            case 5: fd = open(file, O_RDONLY); sc = my_scanner_open_pipeline(fd, 2, 16); break;
+        }
+        if (!sc) { printf("\tCan't open a %s scanner\n", kinds[k]); passed = 0; break; }
+
+        int lines = 0;
+        for (; lines < num_expected && passed; lines++) {
+            char got[300];
+            int which = my_scanner_any_exec(sc, set, dests);
+            switch (which) {
+                case 0: case 8: sprintf(got, "%d %s %d", which, path[which], a[which]); break;
+                case 1: sprintf(got, "1 %s %d %d", path[1], a[1], b[1]); break;
+                case 2: sprintf(got, "2 %d %s", a[2], word[2]); break;
+                case 3: sprintf(got, "3 %s %s", path[3], word[3]); break;
+                case 4: sprintf(got, "4 %d %d", a[4], b[4]); break;
+                case 5: sprintf(got, "5 %g %s", t, word[5]); break;
+                case 6: sprintf(got, "6 %d %s", a[6], word[6]); break;
+                case 7: sprintf(got, "7 %s", z); break;
+                case MY_ANY_NO_MATCH: strcpy(got, "none"); break;
+                case MY_ANY_EOF: strcpy(got, "eof"); break;
+                default: sprintf(got, "? %d", which); break;
+            }
+            if (strcmp(got, expected[lines]) != 0) {
+                printf("\t%s line %d: expected '%s', got '%s'\n", kinds[k], lines + 1, expected[lines], got);
+                passed = 0;
+            }
+        }
+        printf("\t%-6s scanner: %d lines classified\n", kinds[k], lines);
+
+        my_scanner_close(sc);
+        if (stream) fclose(stream);
+        if (fd >= 0) close(fd);
+    }
+
+    // One-off matching of a string, with the formats compiled by the call
+    char ip[64] = {0};
+    int id = -1;
+    void *one[] = { &id, ip };
+    void **one_dests[] = { one, one };
+    int which = my_sscanf_any("user 9 logged in from ::1\n", formats + 2, 2, one_dests);
+    printf("\tmy_sscanf_any(): format %d, %d %s\n", which, id, ip);
+    passed = passed && which == 0 && id == 9 && strcmp(ip, "::1") == 0;
+    passed = passed && my_sscanf_any("", formats, 9, dests) == MY_ANY_EOF;
+
+    my_scanf_set_free(set);
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// MULTIPLEXER RUNNERS
+// test_mux: nstreams streams (alternately socketpairs and pipes) plus a
+// regular file, all registered with one my_scanf_mux. Every stream's text is
+// written a few bytes per round, interleaved with non-blocking my_mux_run
+// calls, so records arrive split at arbitrary points. Stream 0 carries one
+// bad line. Each stream must deliver exactly its own records, one error for
+// the bad line and a single MY_PARSE_END.
+#define MUX_RECORDS 200
+typedef struct {
+    int id;
+    int seq, value;
+    int records, errors, ends, ok;
+    int rfd;              // read end, registered with the mux
+    int wfd;              // write end, -1 once closed
+    char *text;
+    size_t len, pos;
+} MuxTestStream;
+
+typedef struct {
+    int i;
+    float f;
+    char s[256];
+    int records, ends;
+} MuxTestFile;
+
+static void mux_stream_callback(void *user, int fd, int status) {
+    (void)fd;
+    MuxTestStream *st = user;
+    if (status == MY_PARSE_RECORD) {
+        st->ok = st->ok && st->seq == st->records && st->value == st->seq * st->id;
+        st->records++;
+    } else if (status == MY_PARSE_ERROR) {
+        st->errors++;
+    } else {
+        st->ends++;
+    }
+}
+
+static void mux_file_callback(void *user, int fd, int status) {
+    (void)fd;
+    MuxTestFile *f = user;
+    if (status == MY_PARSE_RECORD) f->records++;
+    if (status == MY_PARSE_END) f->ends++;
+}
+
+int test_mux(const char *name, int nstreams) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+    printf("Streams: %d (socketpairs and pipes) + 1 regular file, %d records each\n", nstreams, MUX_RECORDS);
+
+    my_scanf_mux *mx = my_mux_new();
+    MuxTestStream *streams = calloc((size_t)nstreams, sizeof(*streams));
+    void *(*dests)[2] = calloc((size_t)nstreams, sizeof(*dests));
+    int passed = (mx != NULL && streams != NULL && dests != NULL);
+    for (int k = 0; k < nstreams && passed; k++) streams[k].rfd = streams[k].wfd = -1;
+
+    for (int k = 0; k < nstreams && passed; k++) {
+        MuxTestStream *st = &streams[k];
+        int fds[2];
+        int made = (k % 2 == 0) ? socketpair(AF_UNIX, SOCK_STREAM, 0, fds) : pipe(fds);
+        if (made != 0) { printf("\tCan't create stream %d\n", k); passed = 0; break; }
+        st->rfd = fds[0];
+        st->wfd = fds[1];
+        st->id = k + 1;
+        st->ok = 1;
+        st->text = malloc(MUX_RECORDS * 24 + 16);
+        for (int r = 0; r < MUX_RECORDS; r++) {
+            st->len += (size_t)sprintf(st->text + st->len, "%d %d\n", r, r * st->id);
+            if (k == 0 && r == MUX_RECORDS / 2) st->len += (size_t)sprintf(st->text + st->len, "oops\n");
+        }
+        dests[k][0] = &st->seq;
+        dests[k][1] = &st->value;
+        passed = (my_mux_add(mx, fds[0], "%d %d", dests[k], mux_stream_callback, st) == 0);
+    }
+
+    MuxTestFile file = {0};
+    void *file_dests[3] = { &file.i, &file.f, file.s };
+    int file_fd = open("test_inputs/test_compiled_records.txt", O_RDONLY);
+    passed = passed && file_fd >= 0 &&
+             my_mux_add(mx, file_fd, "%d,%f %s", file_dests, mux_file_callback, &file) == 0;
+
+    // Write round-robin in small, uneven pieces
+    for (int round = 0, writing = nstreams; passed && writing > 0; round++) {
+        writing = 0;
+        for (int k = 0; k < nstreams; k++) {
+            MuxTestStream *st = &streams[k];
+            if (st->wfd < 0) continue;
+            size_t piece = 1 + (size_t)((round * 7 + k * 13) % 29);
+            if (piece > st->len - st->pos) piece = st->len - st->pos;
+            ssize_t w = write(st->wfd, st->text + st->pos, piece);
+            if (w > 0) st->pos += (size_t)w;
+            if (st->pos == st->len) {
+                close(st->wfd);
+                st->wfd = -1;
+            } else {
+                writing++;
+            }
+        }
+        if (my_mux_run(mx, 0) < 0) passed = 0;
+    }
+    for (int spins = 0; passed && my_mux_count(mx) > 0 && spins < 10000; spins++) {
+        if (my_mux_run(mx, 1000) < 0) passed = 0;
+    }
+
+    int good = 0;
+    for (int k = 0; k < nstreams && streams != NULL; k++) {
+        MuxTestStream *st = &streams[k];
+        int ok = st->ok && st->records == MUX_RECORDS && st->errors == (k == 0) && st->ends == 1;
+        if (!ok && passed) {
+            printf("\tstream %d: records=%d errors=%d ends=%d values %s\n", k, st->records, st->errors,
+                   st->ends, st->ok ? "ok" : "wrong");
+        }
+        good += ok;
+        if (st->wfd >= 0) close(st->wfd);
+        if (st->rfd >= 0) close(st->rfd);
+        free(st->text);
+    }
+    printf("\t%d of %d streams delivered every record, file: %d records, %d end\n",
+           good, nstreams, file.records, file.ends);
+    passed = passed && good == nstreams && file.records == 4 && file.ends == 1 && my_mux_count(mx) == 0;
+
+    if (file_fd >= 0) close(file_fd);
+    my_mux_free(mx);
+    free(streams);
+    free(dests);
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// READ-AHEAD RUNNERS
+// test_read_ahead: Writes URING_RECORDS "i i*0.5 wI" lines and scans them
+// back through an io_uring scanner (or, with pipeline set, a reader thread
+// scanner) with the given depth and buffer size, so tokens straddle buffer
+// boundaries. From a pipe the lines are written by a
+// second thread while the scanner reads; from a file the scanner starts at a
+// non-zero offset (after a header line) to check the explicit read offsets.
+#define URING_RECORDS 50000
+
+static void *uring_pipe_writer(void *arg) {
+    int fd = *(int *)arg;
+    FILE *fp = fdopen(fd, "w");
+    for (int i = 0; i < URING_RECORDS; i++) {
+        fprintf(fp, "%d %g w%d\n", i, i * 0.5, i);
+    }
+    fclose(fp);
+    return NULL;
+}
+
+int test_read_ahead(const char *name, int pipeline, int depth, size_t buffer_size, int from_pipe) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+    printf("Scanner: %s, depth: %d, buffer: %zu bytes, source: %s\n", pipeline ? "reader thread" : "io_uring",
+           depth, buffer_size, from_pipe ? "pipe" : "file");
+
+    char path[] = "/tmp/my_scanf_uring_XXXXXX";
+    int fd = -1;
+    int wfd = -1;
+    pthread_t writer;
+    if (from_pipe) {
+        int fds[2];
+        if (pipe(fds) == 0) {
+            fd = fds[0];
+            wfd = fds[1];
+            pthread_create(&writer, NULL, uring_pipe_writer, &wfd);
+        }
+    } else {
+        fd = mkstemp(path);
+        FILE *fp = (fd >= 0) ? fdopen(dup(fd), "w") : NULL;
+        if (fp) {
+            fprintf(fp, "header to skip\n");
+            for (int i = 0; i < URING_RECORDS; i++) fprintf(fp, "%d %g w%d\n", i, i * 0.5, i);
+            fclose(fp);
+            lseek(fd, 15, SEEK_SET);
+        }
+    }
+    if (fd < 0) { printf("FAIL: Can't create the input\n"); tests_failed++; return 0; }
+
+    my_scanner_t *sc = pipeline ? my_scanner_open_pipeline(fd, depth, buffer_size)
+                                : my_scanner_open_uring(fd, depth, buffer_size);
+    int passed = (sc != NULL);
+    int records = 0;
+    while (passed) {
+        int i = -1;
+        double d = -1.0;
+        char word[32] = {0};
+        char expected[32];
+        int ret = my_scanner_scanf(sc, "%d %lf %s", &i, &d, word);
+        if (ret == -1 && records == URING_RECORDS) break;
+        sprintf(expected, "w%d", records);
+        if (ret != 3 || i != records || d != records * 0.5 || strcmp(word, expected) != 0) {
+            printf("\trecord %d: ret=%d %d %g '%s'\n", records, ret, i, d, word);
+            passed = 0;
+        }
+        records++;
+    }
+    printf("\t%d records matched\n", records);
+
+    my_scanner_close(sc);
+    if (from_pipe) pthread_join(writer, NULL);
+    close(fd);
+    if (!from_pipe) unlink(path);
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// test_read_ahead_close: Closes read-ahead scanners whose reads are still
+// blocked on a pipe that never gets any data; the close must not hang.
+int test_read_ahead_close(const char *name) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+
+    int fds[2];
+    int passed = (pipe(fds) == 0);
+    if (passed) {
+        my_scanner_t *thread_sc = my_scanner_open_pipeline(fds[0], 0, 0);
+        my_scanner_t *uring_sc = my_scanner_open_uring(fds[0], 0, 0);
+        passed = (thread_sc != NULL && uring_sc != NULL);
+        usleep(10000);  // let both reads block
+        my_scanner_close(thread_sc);
+        my_scanner_close(uring_sc);
+        close(fds[0]);
+        close(fds[1]);
+    }
+    printf("\tclosed both scanners with reads pending\n");
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
+// test_read_error: Scans a directory, whose read(2) fails with EISDIR,
+// through my_fdscanf and the reader-thread and io_uring scanners. The
+// failure must not pass for a clean EOF: all of them return EOF with errno
+// set to the read's error, and the scanners keep reporting it on later
+// calls.
+int test_read_error(const char *name) {
+    tests_run++;
+    printf("\nTEST: %s\n", name);
+
+    int x = 0;
+    int fd = open("test_inputs", O_RDONLY);
+    errno = 0;
+    int fd_ret = (fd >= 0) ? my_fdscanf(fd, "%d", &x) : 0;
+    int fd_errno = errno;
+    my_fdscanf_release(fd);
+    printf("\tmy_fdscanf: %d (%s)\n", fd_ret, strerror(fd_errno));
+    int passed = fd_ret == EOF && fd_errno == EISDIR;
+
+    const char *kinds[2] = { "reader thread", "io_uring" };
+    for (int k = 0; k < 2; k++) {
+        my_scanner_t *sc = NULL;
+        if (fd >= 0) sc = (k == 0) ? my_scanner_open_pipeline(fd, 0, 0) : my_scanner_open_uring(fd, 0, 0);
+        errno = 0;
+        int sc_ret = sc ? my_scanner_scanf(sc, "%d", &x) : 0;
+        int sc_errno = errno;
+        errno = 0;
+        int again_ret = sc ? my_scanner_scanf(sc, "%d", &x) : 0;
+        int again_errno = errno;
+        my_scanner_close(sc);
+        printf("\t%s: %d (%s), again: %d (%s)\n", kinds[k],
+               sc_ret, strerror(sc_errno), again_ret, strerror(again_errno));
+        passed = passed && sc_ret == EOF && sc_errno == EISDIR &&
+                 again_ret == EOF && again_errno == EISDIR;
+    }
+    if (fd >= 0) close(fd);
+
+    printf("Result: %s%s%s\n", passed ? COLOR_GREEN : COLOR_RED, passed ? "PASS" : "FAIL", COLOR_RESET);
+    printf("***\n");
+    if (passed) tests_passed++; else tests_failed++;
+    return passed;
+}
+
 // MAIN TEST SUITE
 int main() {
     printf("\n=== MY_SCANF TEST SUITE ===\n\n");
@@ -954,7 +2732,7 @@ int main() {
     test_int("Double plus sign", "test_inputs/test_int_double_sign.txt", "%d", EXPECT_FAILURE);
     test_int("Sign with space", "test_inputs/test_int_sign_space.txt", "%d", EXPECT_FAILURE);
 
-    printf("\n--- LONG INTEGERS (%%ld, %%lld, %%hd) ---\n");
+    printf("\n--- LONG INTEGERS (%%ld, %%lld, %%hd, %%lx, %%llx, %%hx) ---\n");
     test_long("Long integer", "test_inputs/test_long.txt", "%ld", EXPECT_SUCCESS);
     test_long("Negative long", "test_inputs/test_long_neg.txt", "%ld", EXPECT_SUCCESS);
     test_long("LONG_MAX", "test_inputs/test_long_max.txt", "%ld", EXPECT_SUCCESS);
@@ -962,6 +2740,14 @@ int main() {
     test_long("Long long min", "test_inputs/test_llong_neg.txt", "%lld", EXPECT_SUCCESS);
     test_long("Short max", "test_inputs/test_short.txt", "%hd", EXPECT_SUCCESS);
     test_long("Short min", "test_inputs/test_short_neg.txt", "%hd", EXPECT_SUCCESS);
+    test_long("Long long 19-digit ID", "test_inputs/test_llong_id.txt", "%lld", EXPECT_SUCCESS);
+    test_long("Long long field width 12", "test_inputs/test_llong_id_width.txt", "%12lld", EXPECT_SUCCESS);
+    test_long("Long field width 17", "test_inputs/test_llong_id_width.txt", "%17ld", EXPECT_SUCCESS);
+    test_long("Hex long 16-digit trace ID", "test_inputs/test_hex_trace_id.txt", "%lx", EXPECT_SUCCESS);
+    test_long("Hex long long address", "test_inputs/test_hex_address.txt", "%llx", EXPECT_SUCCESS);
+    test_long("Hex long all ones", "test_inputs/test_hex_all_ones.txt", "%lx", EXPECT_SUCCESS);
+    test_long("Hex long field width 10", "test_inputs/test_hex_trace_id.txt", "%10lx", EXPECT_SUCCESS);
+    test_long("Hex short", "test_inputs/test_hex_short.txt", "%hx", EXPECT_SUCCESS);
 
     printf("\n--- MULTIPLE INTEGERS ---\n");
     test_multiple_ints("Two integers", "test_inputs/test_two_ints.txt", "%d %d", 2);
@@ -987,6 +2773,10 @@ int main() {
     printf("\n--- DOUBLE PRECISION ---\n");
     test_double("Double precision", "test_inputs/test_double.txt", "%Lf", EXPECT_SUCCESS);
     test_double("Long double", "test_inputs/test_long_double.txt", "%Lf", EXPECT_SUCCESS);
+    test_double_exact("Double 17 significant digits", "test_inputs/test_double_17_digits.txt");
+    test_double_exact("Double more digits than fit", "test_inputs/test_double_many_digits.txt");
+    test_double_exact("Double large exponent", "test_inputs/test_double_large_exp.txt");
+    test_double_exact("Double bare exponent (1e)", "test_inputs/test_float_bare_exponent.txt");
 
     printf("\n--- HEXADECIMAL (%%x) ---\n");
     test_int("Hex lowercase", "test_inputs/test_hex.txt", "%x", EXPECT_SUCCESS);
@@ -995,6 +2785,8 @@ int main() {
     test_int("Hex zero", "test_inputs/test_hex_zero.txt", "%x", EXPECT_SUCCESS);
     test_int("Hex field width 3", "test_inputs/test_hex_width3.txt", "%3x", EXPECT_SUCCESS);
     test_int("Hex negative", "test_inputs/test_hex_negative.txt", "%x", EXPECT_SUCCESS);
+    test_int("Hex bare prefix (0xz)", "test_inputs/test_hex_prefix_only.txt", "%x", EXPECT_SUCCESS);
+    test_int("Hex field width 2 with leading zero", "test_inputs/test_hex_width2_leading_zero.txt", "%2x", EXPECT_SUCCESS);
 
     printf("\n--- CHARACTER & STRING ---\n");
     test_string("Single character", "test_inputs/test_char_a.txt", "%c", EXPECT_SUCCESS);
@@ -1015,6 +2807,10 @@ int main() {
     test_binary("Binary negative", "test_inputs/test_binary_negative.txt");
     test_binary("Binary 8 bits", "test_inputs/test_binary_eight_bits.txt");
     test_binary("Binary 32 bits", "test_inputs/test_binary_large.txt");
+    test_binary_long("Binary 64-bit bitmap", "test_inputs/test_binary_64_bits.txt", "%llb", 0);
+    test_binary_long("Binary 48 bits with prefix", "test_inputs/test_binary_48_prefix.txt", "%lb", 0);
+    test_binary_long("Binary 40 bits negative", "test_inputs/test_binary_40_negative.txt", "%llb", 0);
+    test_binary_long("Binary field width 37", "test_inputs/test_binary_64_bits.txt", "%37llb", 37);
 
     printf("\n--- CUSTOM %%z (GEN Z) ---\n");
     test_genz("Simple gen z", "test_inputs/test_genz_simple.txt", "%z", "hello world lol");
@@ -1075,6 +2871,8 @@ int main() {
     printf("\n--- COMBO: WHITESPACE HANDLING ---\n");
     test_suppress_three("Whitespace Between Ints", "test_inputs/test_combo_whitespace_int_int.txt", "%d %d %d");
     test_suppress_string("Whitespace Between Strings", "test_inputs/test_combo_whitespace_string_string.txt", "%s %s");
+    test_combo_two_ints("Long Space Padding Between Ints", "test_inputs/test_padded_ints.txt", "%d%d");
+    test_string("Mixed Whitespace Padding Before String", "test_inputs/test_padded_string.txt", "%s", EXPECT_SUCCESS);
 
     printf("\n--- COMBO: PARTIAL FAILURES ---\n");
     test_int("First fails", "test_inputs/test_combo_first_fails.txt", "%d", EXPECT_FAILURE);
@@ -1098,6 +2896,107 @@ int main() {
     test_int("Percent literal partial: missing %%", "test_inputs/test_percent_missing.txt", "%d%%", EXPECT_SUCCESS);
     test_suppress_string("Percent literal: '10%% cheaper'", "test_inputs/test_percent_string.txt", "%d%% %s");
 
+    printf("\n--- INPUT SOURCES (my_sscanf, my_fscanf, my_fdscanf) ---\n");
+    test_frontends("Int + Float + String", "test_inputs/test_combo_int_float_string.txt", "%d %f %s");
+    test_frontends("First fails", "test_inputs/test_combo_first_fails.txt", "%d %f %s");
+    test_frontends("Empty input", "test_inputs/test_empty.txt", "%d %f %s");
+    test_file_position("FILE* offsets track fscanf", "%d,%f %31s", -1);
+    test_file_position("FILE* offsets after a bad row", "%d,%f %31s", 3210);
+    test_fd_continuation("fd resumes after pushback", "test_inputs/test_two_ints.txt", 10, 20);
+    test_fscanf_then_fgets("Stream position after %d", "test_inputs/test_two_ints.txt", "%d");
+    test_fscanf_then_fgets("Stream position after trailing letter", "test_inputs/test_trailing_letter.txt", "%d");
+    test_mmap_records("Mapped records", "test_inputs/test_compiled_records.txt", "%d,%f %s", 0);
+    test_mmap_records("Mapped records, prefaulted", "test_inputs/test_compiled_records.txt", "%d,%f %s", MY_MMAP_POPULATE);
+    test_mmap_records("Mapped records, huge pages", "test_inputs/test_compiled_records.txt", "%d,%f %s", MY_MMAP_HUGEPAGE);
+    test_mmap_records("Mapped empty file", "test_inputs/test_empty.txt", "%d,%f %s", 0);
+
+    printf("\n--- ZERO-COPY VIEWS (%%v) ---\n");
+    test_view("Token view", "test_inputs/test_combo_int_string.txt", "%*d %v", 1, "hello");
+    test_view("Token view with width", "test_inputs/test_string_field_width.txt", "%5v", 1, "hello");
+    test_view("Token view after padding", "test_inputs/test_padded_string.txt", "%v", 1, "padded_word");
+    test_view("Line view", "test_inputs/test_genz_simple.txt", "%!v", 1, "hello world");
+    test_view("Line view trims whitespace", "test_inputs/test_genz_whitespace.txt", "%!v", 1, "there's lots of leading and trailing whitespace");
+    test_view("Line view on next line", "test_inputs/test_combo_int_genz.txt", "%*d\n%!v", 1, "hello world");
+    test_view("View of empty input", "test_inputs/test_empty.txt", "%v", -1, "");
+
+    printf("\n--- SCANNER CONTEXTS (my_scanner_t) ---\n");
+    test_scanner_records("Records from every scanner kind", "test_inputs/test_compiled_records.txt", "%d,%f %s");
+    test_scanner_records("Scanner stops at literal mismatch", "test_inputs/test_compiled_records.txt", "%d;%f %s");
+    test_scanner_checkpoint("Mixed line shapes with rollback", "test_inputs/test_mixed_shapes.txt");
+    test_scanner_threads("Independent scanners on 4 threads", 4);
+    test_fdscanf_threads("my_fdscanf on 8 threads at once", 8);
+    test_read_ahead("io_uring file, 4 reads of 4 KiB in flight", 0, 4, 4096, 0);
+    test_read_ahead("io_uring file, defaults", 0, 0, 0, 0);
+    test_read_ahead("io_uring file, tiny buffers", 0, 8, 64, 0);
+    test_read_ahead("io_uring pipe with a concurrent writer", 0, 4, 4096, 1);
+    test_read_ahead("Reader thread file, defaults", 1, 0, 0, 0);
+    test_read_ahead("Reader thread file, tiny buffers", 1, 3, 64, 0);
+    test_read_ahead("Reader thread pipe with a concurrent writer", 1, 4, 4096, 1);
+    test_read_ahead_close("Close with reads pending");
+    test_read_error("Read errors reach errno");
+
+    printf("\n--- PUSH PARSING (my_parser_feed) ---\n");
+    test_parser_records("Records fed one byte at a time", "test_inputs/test_compiled_records.txt", "%d,%f %s", 1);
+    test_parser_records("Records fed 7 bytes at a time", "test_inputs/test_compiled_records.txt", "%d,%f %s", 7);
+    test_parser_records("Records fed in one piece", "test_inputs/test_compiled_records.txt", "%d,%f %s", 4096);
+    test_parser_records("Parser reports literal mismatch", "test_inputs/test_compiled_records.txt", "%d;%f %s", 3);
+    test_parser_resync("Bad line skipped, last record at finish");
+
+    printf("\n--- MULTI-FORMAT MATCHING (my_scanf_any) ---\n");
+    test_scanf_any("Mixed log lines against 9 formats", "test_inputs/test_any_lines.txt");
+
+    printf("\n--- MULTIPLEXED STREAMS (my_scanf_mux) ---\n");
+    test_mux("One stream", 1);
+    test_mux("200 interleaved streams", 200);
+
+    printf("\n--- COMPILED FORMATS (my_scanf_compile) ---\n");
+    test_compiled_records("Records: int,float string", "test_inputs/test_compiled_records.txt", "%d,%f %s");
+    test_compiled_records("Records: literal mismatch stops", "test_inputs/test_compiled_records.txt", "%d;%f %s");
+    test_compiled_records("Records: whitespace around literal", "test_inputs/test_compiled_records.txt", "%d , %f %s");
+
+    printf("\n--- BULK COLUMNS (my_scan_columns) ---\n");
+    test_columns("All records into columns", "test_inputs/test_compiled_records.txt", 16, 4);
+    test_columns("Stops at record limit", "test_inputs/test_compiled_records.txt", 2, 2);
+    test_columns("Stops at first bad record", "test_inputs/test_combo_literal_int_comma_int.txt", 16, 0);
+
+    printf("\n--- PARALLEL SCANNING (my_scan_columns_parallel) ---\n");
+    test_columns_parallel("Single thread", 1, -1, 0, PARALLEL_ROWS);
+    test_columns_parallel("Four threads", 4, -1, 0, PARALLEL_ROWS);
+    test_columns_parallel("Four threads, bad record mid-file", 4, 200000, 0, PARALLEL_ROWS);
+    test_columns_parallel("One thread per CPU", 0, -1, 0, PARALLEL_ROWS);
+    test_columns_parallel("Blank lines leave gaps to close", 4, -1, 7, PARALLEL_ROWS);
+    test_columns_parallel("Blank lines, then a bad record", 4, 250000, 3, PARALLEL_ROWS);
+    test_columns_parallel("Room for the first chunk only", 4, -1, 0, 1000);
+    test_columns_parallel("Room ends mid-file", 4, -1, 5, 150000);
+    test_columns_parallel("Room ends on a chunk boundary after gaps", 4, -1, 1, 0);
+    test_columns_parallel_views("Views refused, caller-owned mapping works", "test_inputs/test_compiled_records.txt");
+
+    printf("\n--- CIPHER STREAMS (my_cipher_stream) ---\n");
+    test_cipher_stream("Shift 3 over a large file", 3, 0);
+    test_cipher_stream("Shift 13 with case inversion", 13, 1);
+    test_cipher_stream("Shift 0 copies the input", 0, 0);
+
+    printf("\n--- GEN-Z STREAMS (my_genz_stream) ---\n");
+    test_genz_stream("lol suffix, every line shape", MY_GENZ_LOL, "%z");
+    test_genz_stream("lol! suffix, every line shape", MY_GENZ_LOL_EXCLAIM, "%!z");
+    test_genz_stream("haha! suffix, every line shape", MY_GENZ_HAHA, "%!hz");
+
+    printf("\n--- LINE ALLOCATION (%%mq, %%mz) ---\n");
+    test_line_alloc("%mz over lines up to 6 KB", "test_inputs/test_long_free_text.txt", "%mz");
+    test_line_alloc("%!mhz over lines up to 6 KB", "test_inputs/test_long_free_text.txt", "%!mhz");
+    test_line_alloc("%7mq over lines up to 6 KB", "test_inputs/test_long_free_text.txt", "%7mq");
+    test_line_alloc("%!20mq over lines up to 6 KB", "test_inputs/test_long_free_text.txt", "%!20mq");
+    test_line_alloc_limits("Widths, suppression and refusals", "test_inputs/test_long_free_text.txt");
+    test_line_cap("%z cut at the array size on every source", "test_inputs/test_line_cap.txt", "%z");
+    test_line_cap("%!hz cut at the array size on every source", "test_inputs/test_line_cap.txt", "%!hz");
+    test_line_cap("%5q cut at the array size on every source", "test_inputs/test_line_cap.txt", "%5q");
+
+    printf("\n--- SIMD KERNELS (my_scanf_use_kernels) ---\n");
+    test_kernels("Every kernel set matches scalar");
+
+    printf("\n--- INSTRUMENTATION (my_scanf_stats) ---\n");
+    test_stats("Counters after known scans");
+
     printf("\n========================================\n");
     printf("TEST SUMMARY\n");
     printf("  Tests run:    %d\n", tests_run);